@@ -0,0 +1,284 @@
+#include "allocator.h"
+#include "raylib.h"
+
+#include <assert.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define blockHeaderSize 16
+#define blockMagicHeap 0x48454150u      // "HEAP"
+#define blockMagicArena 0x4152454eu     // "AREN"
+#define arenaAlignment 16
+
+// Prefix of every block handed out by the hooks; the size is needed for live byte tracking and arena realloc
+typedef struct {
+    size_t size;
+    unsigned int site;      // Index + 1 into the site table, 0 when the block was not tracked
+    unsigned int magic;
+} BlockHeader;
+
+typedef struct {
+    AllocatorMode mode;
+    long long allocations;
+    pthread_mutex_t lock;   // Site table only, taken in tracking mode
+    AllocationSite sites[allocatorMaxSites];
+    int siteCount;
+    int droppedSites;
+} Allocator;
+
+static Allocator allocator = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static _Thread_local Arena *activeArena = NULL;
+static _Thread_local const char *noAllocationZone = NULL;
+static _Thread_local bool noAllocationSuspended = false;
+
+_Static_assert(sizeof(BlockHeader) <= blockHeaderSize, "block header must fit in the aligned prefix");
+
+void SetAllocatorMode(AllocatorMode mode) {
+    allocator.mode = mode;
+}
+
+AllocatorMode GetAllocatorMode(void) {
+    return allocator.mode;
+}
+
+long long GetAllocationCount(void) {
+    return __atomic_load_n(&allocator.allocations, __ATOMIC_RELAXED);
+}
+
+// Linear probing on (file, line); file names are string literals so the pointer identifies the file
+static unsigned int FindSite(const char *file, int line) {
+    unsigned int hash = (unsigned int)(((size_t)file >> 4) * 31u + (unsigned int)line);
+    for (int probe = 0; probe < allocatorMaxSites; probe++) {
+        AllocationSite *site = &allocator.sites[(hash + probe) % allocatorMaxSites];
+        if (site->file == NULL) {
+            site->file = file;
+            site->line = line;
+            allocator.siteCount++;
+            return (hash + probe) % allocatorMaxSites + 1;
+        }
+        if ((site->file == file) && (site->line == line)) return (hash + probe) % allocatorMaxSites + 1;
+    }
+    allocator.droppedSites++;
+    return 0;
+}
+
+static void TrackAllocation(BlockHeader *header, const char *file, int line, bool live) {
+    header->site = 0;
+    if (allocator.mode != ALLOCATOR_TRACKING) return;
+
+    pthread_mutex_lock(&allocator.lock);
+    header->site = FindSite(file, line);
+    if (header->site > 0) {
+        AllocationSite *site = &allocator.sites[header->site - 1];
+        site->calls++;
+        site->bytes += header->size;
+        if (live) {
+            site->liveCount++;
+            site->liveBytes += header->size;
+        }
+    }
+    pthread_mutex_unlock(&allocator.lock);
+}
+
+static void UntrackAllocation(const BlockHeader *header) {
+    if (header->site == 0) return;
+
+    pthread_mutex_lock(&allocator.lock);
+    AllocationSite *site = &allocator.sites[header->site - 1];
+    site->liveCount--;
+    site->liveBytes -= header->size;
+    pthread_mutex_unlock(&allocator.lock);
+}
+
+static void CheckNoAllocationZone(size_t size, const char *file, int line) {
+#if !defined(NDEBUG)
+    if ((noAllocationZone != NULL) && !noAllocationSuspended) {
+        TraceLog(LOG_ERROR, "ALLOC: %zu bytes allocated at %s:%d inside the %s no-allocation zone", size, file, line, noAllocationZone);
+        assert(!"heap allocation inside a no-allocation zone");
+    }
+#else
+    (void)size; (void)file; (void)line;
+#endif
+}
+
+static BlockHeader *GetHeader(void *ptr) {
+    BlockHeader *header = (BlockHeader *)((unsigned char *)ptr - blockHeaderSize);
+    assert(((header->magic == blockMagicHeap) || (header->magic == blockMagicArena)) && "pointer was not allocated through the hooks");
+    return header;
+}
+
+void *AllocatorMalloc(size_t size, const char *file, int line) {
+    CheckNoAllocationZone(size, file, line);
+
+    BlockHeader *header = malloc(blockHeaderSize + size);
+    if (header == NULL) return NULL;
+
+    header->size = size;
+    header->magic = blockMagicHeap;
+    TrackAllocation(header, file, line, true);
+    __atomic_fetch_add(&allocator.allocations, 1, __ATOMIC_RELAXED);
+    return (unsigned char *)header + blockHeaderSize;
+}
+
+void *AllocatorCalloc(size_t count, size_t size, const char *file, int line) {
+    if ((size > 0) && (count > ((size_t)-1 - blockHeaderSize) / size)) return NULL;
+
+    void *ptr = AllocatorMalloc(count * size, file, line);
+    if (ptr != NULL) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void AllocatorFree(void *ptr) {
+    if (ptr == NULL) return;
+
+    BlockHeader *header = GetHeader(ptr);
+    if (header->magic == blockMagicArena) return;   // Released with the whole arena
+
+    UntrackAllocation(header);
+    header->magic = 0;
+    free(header);
+}
+
+void *AllocatorRealloc(void *ptr, size_t size, const char *file, int line) {
+    if (ptr == NULL) return GameMalloc(size, file, line);
+    if (size == 0) {
+        AllocatorFree(ptr);
+        return NULL;
+    }
+
+    BlockHeader *header = GetHeader(ptr);
+
+    // Arena blocks cannot grow in place, move them to wherever new game allocations go right now
+    if (header->magic == blockMagicArena) {
+        void *moved = GameMalloc(size, file, line);
+        if (moved != NULL) memcpy(moved, ptr, (header->size < size) ? header->size : size);
+        return moved;
+    }
+
+    CheckNoAllocationZone(size, file, line);
+    UntrackAllocation(header);
+
+    BlockHeader *resized = realloc(header, blockHeaderSize + size);
+    if (resized == NULL) {
+        TrackAllocation(header, file, line, true);
+        return NULL;
+    }
+
+    resized->size = size;
+    TrackAllocation(resized, file, line, true);
+    __atomic_fetch_add(&allocator.allocations, 1, __ATOMIC_RELAXED);
+    return (unsigned char *)resized + blockHeaderSize;
+}
+
+void *GameMalloc(size_t size, const char *file, int line) {
+    if (activeArena == NULL) return AllocatorMalloc(size, file, line);
+
+    BlockHeader *header = ArenaAlloc(activeArena, blockHeaderSize + size);
+    if (header == NULL) {
+        TraceLog(LOG_WARNING, "ALLOC: Arena full (%zu of %zu bytes used), %zu bytes at %s:%d go to the heap",
+                 activeArena->used, activeArena->capacity, size, file, line);
+        return AllocatorMalloc(size, file, line);
+    }
+
+    header->size = size;
+    header->magic = blockMagicArena;
+    TrackAllocation(header, file, line, false);
+    return (unsigned char *)header + blockHeaderSize;
+}
+
+void *GameCalloc(size_t count, size_t size, const char *file, int line) {
+    if ((size > 0) && (count > ((size_t)-1 - blockHeaderSize) / size)) return NULL;
+
+    void *ptr = GameMalloc(count * size, file, line);
+    if (ptr != NULL) memset(ptr, 0, count * size);
+    return ptr;
+}
+
+void InitArena(Arena *arena, size_t capacity) {
+    arena->base = AllocatorMalloc(capacity, __FILE__, __LINE__);
+    arena->capacity = (arena->base != NULL) ? capacity : 0;
+    arena->used = 0;
+    arena->peak = 0;
+}
+
+void FreeArena(Arena *arena) {
+    AllocatorFree(arena->base);
+    arena->base = NULL;
+    arena->capacity = 0;
+    arena->used = 0;
+}
+
+void ResetArena(Arena *arena) {
+    arena->used = 0;
+}
+
+void *ArenaAlloc(Arena *arena, size_t size) {
+    size_t offset = (arena->used + arenaAlignment - 1) & ~(size_t)(arenaAlignment - 1);
+    if ((offset > arena->capacity) || (size > arena->capacity - offset)) return NULL;
+
+    arena->used = offset + size;
+    if (arena->used > arena->peak) arena->peak = arena->used;
+    return arena->base + offset;
+}
+
+void BeginArenaAllocations(Arena *arena) {
+    activeArena = arena;
+}
+
+void EndArenaAllocations(void) {
+    activeArena = NULL;
+}
+
+void BeginNoAllocationZone(const char *name) {
+    noAllocationZone = name;
+    noAllocationSuspended = false;
+}
+
+void EndNoAllocationZone(void) {
+    noAllocationZone = NULL;
+}
+
+void SuspendNoAllocationZone(bool suspend) {
+    noAllocationSuspended = suspend;
+}
+
+static int CompareSitesByBytes(const void *a, const void *b) {
+    const AllocationSite *siteA = a;
+    const AllocationSite *siteB = b;
+    return (siteA->bytes < siteB->bytes) - (siteA->bytes > siteB->bytes);
+}
+
+void ReportAllocations(int maxSites) {
+    if (allocator.mode != ALLOCATOR_TRACKING) {
+        TraceLog(LOG_INFO, "ALLOC: %lld heap allocations through the hooks (tracking off)", GetAllocationCount());
+        return;
+    }
+
+    pthread_mutex_lock(&allocator.lock);
+    AllocationSite *sorted = malloc(allocatorMaxSites * sizeof(AllocationSite));
+    int count = 0;
+    long long liveCount = 0, liveBytes = 0;
+    for (int i = 0; i < allocatorMaxSites; i++) {
+        if (allocator.sites[i].file == NULL) continue;
+        sorted[count++] = allocator.sites[i];
+        liveCount += allocator.sites[i].liveCount;
+        liveBytes += allocator.sites[i].liveBytes;
+    }
+    int droppedSites = allocator.droppedSites;
+    pthread_mutex_unlock(&allocator.lock);
+
+    qsort(sorted, count, sizeof(AllocationSite), CompareSitesByBytes);
+
+    TraceLog(LOG_INFO, "ALLOC: %lld heap allocations from %d call sites, %lld blocks (%lld bytes) still live",
+             GetAllocationCount(), count, liveCount, liveBytes);
+    for (int i = 0; (i < count) && (i < maxSites); i++) {
+        const AllocationSite *site = &sorted[i];
+        TraceLog(LOG_INFO, "ALLOC:     %s:%d  %lld calls  %lld bytes  %lld live (%lld bytes)",
+                 site->file, site->line, site->calls, site->bytes, site->liveCount, site->liveBytes);
+    }
+    if (droppedSites > 0) TraceLog(LOG_WARNING, "ALLOC: Site table full, %d allocations were not attributed", droppedSites);
+
+    free(sorted);
+}
@@ -0,0 +1,70 @@
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include "rlalloc.h"
+
+#define allocatorMaxSites 1024
+
+typedef enum AllocatorMode {
+    ALLOCATOR_SYSTEM,       // Straight to malloc, only totals are kept
+    ALLOCATOR_TRACKING      // Calls, bytes and live blocks per call site
+} AllocatorMode;
+
+typedef struct {
+    const char *file;
+    int line;
+    long long calls;
+    long long bytes;
+    long long liveCount;
+    long long liveBytes;
+} AllocationSite;
+
+// Bump allocator for data that lives exactly as long as something else (a level); nothing is freed individually
+typedef struct {
+    unsigned char *base;
+    size_t capacity;
+    size_t used;
+    size_t peak;
+} Arena;
+
+// Game code allocates through these so it is tracked next to raylib, and can be pointed at an arena
+#define GAME_MALLOC(size) GameMalloc(size, __FILE__, __LINE__)
+#define GAME_CALLOC(count, size) GameCalloc(count, size, __FILE__, __LINE__)
+#define GAME_REALLOC(ptr, size) AllocatorRealloc(ptr, size, __FILE__, __LINE__)
+#define GAME_FREE(ptr) AllocatorFree(ptr)
+
+// Debug builds fail an assertion on any heap allocation made through the hooks inside a zone
+#if !defined(NDEBUG)
+    #define NO_ALLOCATIONS_BEGIN(name) BeginNoAllocationZone(name)
+    #define NO_ALLOCATIONS_END() EndNoAllocationZone()
+    #define NO_ALLOCATIONS_SUSPEND() SuspendNoAllocationZone(true)
+    #define NO_ALLOCATIONS_RESUME() SuspendNoAllocationZone(false)
+#else
+    #define NO_ALLOCATIONS_BEGIN(name) ((void)0)
+    #define NO_ALLOCATIONS_END() ((void)0)
+    #define NO_ALLOCATIONS_SUSPEND() ((void)0)
+    #define NO_ALLOCATIONS_RESUME() ((void)0)
+#endif
+
+void SetAllocatorMode(AllocatorMode mode);      // Can be switched at any time, tracking only sees calls made while it is on
+AllocatorMode GetAllocatorMode(void);
+long long GetAllocationCount(void);             // Heap allocations made through the hooks, in any mode
+void ReportAllocations(int maxSites);           // Log the busiest call sites and everything still live
+
+void *GameMalloc(size_t size, const char *file, int line);              // From the calling thread's arena when one is active
+void *GameCalloc(size_t count, size_t size, const char *file, int line);
+
+void InitArena(Arena *arena, size_t capacity);
+void FreeArena(Arena *arena);
+void ResetArena(Arena *arena);                  // O(1), every block handed out so far becomes invalid
+void *ArenaAlloc(Arena *arena, size_t size);    // 16 byte aligned, NULL when the arena is full
+void BeginArenaAllocations(Arena *arena);       // GAME_MALLOC/GAME_CALLOC on this thread come from the arena until the matching end
+void EndArenaAllocations(void);
+
+void BeginNoAllocationZone(const char *name);
+void EndNoAllocationZone(void);
+void SuspendNoAllocationZone(bool suspend);     // For known, opt-in allocations such as capture readback
+
+#endif
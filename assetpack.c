@@ -0,0 +1,424 @@
+#include "assetpack.h"
+#include "allocator.h"
+#include "timing.h"
+#include "trace.h"
+#include "external/sinfl.h"     // Implementation is compiled into raylib (SUPPORT_COMPRESSION_API)
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#define fontGlyphCount 95       // ASCII 32..126, same as raylib's LoadFont
+#define fontGlyphPadding 4
+
+_Static_assert(sizeof(AssetPackHeader) == 16, "asset pack header layout is part of the file format");
+_Static_assert(sizeof(AssetEntry) == 72, "asset entry layout is part of the file format");
+
+typedef enum {
+    SLOT_QUEUED,
+    SLOT_DECODED,           // CPU side done, waiting for the main thread
+    SLOT_READY,
+    SLOT_FAILED,
+    SLOT_SKIPPED            // Failed and counted by the main thread
+} SlotState;
+
+typedef struct {
+    const AssetEntry *entry;
+    int state;                  // SlotState, stored with release by the workers and loaded with acquire
+    unsigned char *buffer;      // Decompressed blob, NULL while the blob is used in place
+    const unsigned char *data;  // ASSET_RAW: the bytes handed out
+    Image image;                // ASSET_IMAGE, or the glyph atlas of ASSET_FONT
+    GlyphInfo *glyphs;
+    Rectangle *recs;
+    Wave wave;
+    Texture2D texture;
+    Font font;
+    Sound sound;
+} AssetSlot;
+
+static struct {
+    bool open;
+    bool joined;
+    char path[256];
+    const unsigned char *data;  // The mapped pack
+    size_t size;
+    AssetSlot *slots;
+    int count;
+    int next;                   // Next slot for a worker to claim
+    int stopping;
+    int done;                   // Main thread: slots READY or SKIPPED
+    int failed;
+    double openTime;
+    pthread_t workers[assetWorkerCount];
+} pack = { 0 };
+
+#if !defined(_WIN32)
+static const unsigned char *MapPack(const char *path, size_t *size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat info;
+    void *data = NULL;
+    if ((fstat(fd, &info) == 0) && (info.st_size > 0)) {
+        data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) data = NULL;
+        else *size = (size_t)info.st_size;
+    }
+    close(fd);
+    return data;
+}
+
+static void UnmapPack(const unsigned char *data, size_t size) {
+    munmap((void *)data, size);
+}
+#else
+static const unsigned char *MapPack(const char *path, size_t *size) {
+    int length = 0;
+    unsigned char *data = LoadFileData(path, &length);
+    *size = (size_t)length;
+    return data;
+}
+
+static void UnmapPack(const unsigned char *data, size_t size) {
+    (void)size;
+    UnloadFileData((unsigned char *)data);
+}
+#endif
+
+// raylib's file format switches are private to it: without RAYLIB_CUSTOM_FORMATS this assumes its
+// default config.h, a customized build (RAYLIB_TRIMMED) passes its SUPPORT_FILEFORMAT_* on
+#if !defined(RAYLIB_CUSTOM_FORMATS)
+    #define SUPPORT_FILEFORMAT_PNG
+    #define SUPPORT_FILEFORMAT_GIF
+    #define SUPPORT_FILEFORMAT_QOI
+    #define SUPPORT_FILEFORMAT_DDS
+    #define SUPPORT_FILEFORMAT_TTF
+    #define SUPPORT_FILEFORMAT_WAV
+    #define SUPPORT_FILEFORMAT_OGG
+    #define SUPPORT_FILEFORMAT_MP3
+    #define SUPPORT_FILEFORMAT_QOA
+#endif
+
+typedef struct {
+    const char *extension;
+    AssetType type;
+} AssetFormat;
+
+static const AssetFormat assetFormats[] = {
+#if defined(SUPPORT_FILEFORMAT_PNG)
+    { ".png", ASSET_IMAGE },
+#endif
+#if defined(SUPPORT_FILEFORMAT_BMP)
+    { ".bmp", ASSET_IMAGE },
+#endif
+#if defined(SUPPORT_FILEFORMAT_TGA)
+    { ".tga", ASSET_IMAGE },
+#endif
+#if defined(SUPPORT_FILEFORMAT_JPG)
+    { ".jpg", ASSET_IMAGE },
+#endif
+#if defined(SUPPORT_FILEFORMAT_GIF)
+    { ".gif", ASSET_IMAGE },
+#endif
+#if defined(SUPPORT_FILEFORMAT_QOI)
+    { ".qoi", ASSET_IMAGE },
+#endif
+#if defined(SUPPORT_FILEFORMAT_PSD)
+    { ".psd", ASSET_IMAGE },
+#endif
+#if defined(SUPPORT_FILEFORMAT_DDS)
+    { ".dds", ASSET_IMAGE },
+#endif
+#if defined(SUPPORT_FILEFORMAT_HDR)
+    { ".hdr", ASSET_IMAGE },
+#endif
+#if defined(SUPPORT_FILEFORMAT_TTF)
+    { ".ttf", ASSET_FONT },
+    { ".otf", ASSET_FONT },
+#endif
+#if defined(SUPPORT_FILEFORMAT_WAV)
+    { ".wav", ASSET_SOUND },
+#endif
+#if defined(SUPPORT_FILEFORMAT_OGG)
+    { ".ogg", ASSET_SOUND },
+#endif
+#if defined(SUPPORT_FILEFORMAT_MP3)
+    { ".mp3", ASSET_SOUND },
+#endif
+#if defined(SUPPORT_FILEFORMAT_QOA)
+    { ".qoa", ASSET_SOUND },
+#endif
+#if defined(SUPPORT_FILEFORMAT_FLAC)
+    { ".flac", ASSET_SOUND },
+#endif
+    { NULL, ASSET_RAW }
+};
+
+// Every media format in the table above, whether this raylib decodes it or not
+#define ASSET_MEDIA_EXTENSIONS ".png;.bmp;.tga;.jpg;.gif;.qoi;.psd;.dds;.hdr;.ttf;.otf;.wav;.ogg;.mp3;.qoa;.flac"
+
+AssetType GetAssetTypeFromName(const char *name) {
+    for (int i = 0; assetFormats[i].extension != NULL; i++) {
+        if (IsFileExtension(name, assetFormats[i].extension)) return assetFormats[i].type;
+    }
+    if (IsFileExtension(name, ASSET_MEDIA_EXTENSIONS)) return ASSET_UNSUPPORTED;
+    return ASSET_RAW;
+}
+
+// Worker side: everything that needs no GPU or audio device
+static bool DecodeAsset(AssetSlot *slot) {
+    const AssetEntry *entry = slot->entry;
+    const unsigned char *data = pack.data + entry->offset;
+    int size = (int)entry->size;
+
+    // Packed by a raylib with more file formats than the one running
+    if (GetAssetTypeFromName(entry->name) == ASSET_UNSUPPORTED) {
+        TraceLog(LOG_WARNING, "ASSETS: [%s] raylib was built without support for %s", pack.path, entry->name);
+        return false;
+    }
+    if (entry->compressed) {
+        slot->buffer = GAME_MALLOC(entry->size);
+        if (sinflate(slot->buffer, size, data, (int)entry->packedSize) != size) return false;
+        data = slot->buffer;
+    }
+
+    const char *fileType = strrchr(entry->name, '.');
+    if (fileType == NULL) fileType = "";
+    bool decoded = true;
+    switch ((AssetType)entry->type) {
+        case ASSET_IMAGE:
+            slot->image = LoadImageFromMemory(fileType, data, size);
+            decoded = (slot->image.data != NULL);
+            break;
+        case ASSET_FONT:
+            slot->glyphs = LoadFontData(data, size, assetFontSize, NULL, fontGlyphCount, FONT_DEFAULT);
+            if (slot->glyphs != NULL) slot->image = GenImageFontAtlas(slot->glyphs, &slot->recs, fontGlyphCount, assetFontSize, fontGlyphPadding, 0);
+            decoded = (slot->image.data != NULL);
+            if (!decoded && (slot->glyphs != NULL)) UnloadFontData(slot->glyphs, fontGlyphCount);
+            break;
+        case ASSET_SOUND:
+            slot->wave = LoadWaveFromMemory(fileType, data, size);
+            decoded = (slot->wave.data != NULL);
+            break;
+        case ASSET_RAW:
+            slot->data = data;
+            return true;
+        case ASSET_UNSUPPORTED:
+            decoded = false;
+            break;
+    }
+
+    // Decoders copy what they keep, the decompressed blob is not needed any more
+    GAME_FREE(slot->buffer);
+    slot->buffer = NULL;
+    return decoded;
+}
+
+static void *DecodeWorker(void *argument) {
+    (void)argument;
+    TraceSetThreadName("asset decode");
+
+    while (!__atomic_load_n(&pack.stopping, __ATOMIC_RELAXED)) {
+        int index = __atomic_fetch_add(&pack.next, 1, __ATOMIC_RELAXED);
+        if (index >= pack.count) break;
+
+        AssetSlot *slot = &pack.slots[index];
+        double start = GetMonotonicTime();
+        bool decoded = DecodeAsset(slot);
+        TraceComplete("asset decode", start, GetMonotonicTime());
+
+        if (!decoded) TraceLog(LOG_WARNING, "ASSETS: [%s] Failed to decode %s", pack.path, slot->entry->name);
+        __atomic_store_n(&slot->state, decoded ? SLOT_DECODED : SLOT_FAILED, __ATOMIC_RELEASE);
+    }
+    return NULL;
+}
+
+static bool IsPackValid(const unsigned char *data, size_t size) {
+    const AssetPackHeader *header = (const AssetPackHeader *)data;
+    if ((size < sizeof(AssetPackHeader)) || (header->magic != assetPackMagic) || (header->version != assetPackVersion)) return false;
+    if ((header->indexOffset > size) || (header->assetCount > (size - header->indexOffset) / sizeof(AssetEntry))) return false;
+
+    const AssetEntry *entries = (const AssetEntry *)(data + header->indexOffset);
+    for (unsigned int i = 0; i < header->assetCount; i++) {
+        const AssetEntry *entry = &entries[i];
+        if ((entry->offset > size) || (entry->packedSize > size - entry->offset)) return false;
+        if (!entry->compressed && (entry->packedSize != entry->size)) return false;
+        if (memchr(entry->name, '\0', assetNameLength) == NULL) return false;
+    }
+    return true;
+}
+
+bool OpenAssetPack(const char *path) {
+    if (pack.open) CloseAssetPack();
+
+    size_t size = 0;
+    const unsigned char *data = MapPack(path, &size);
+    if (data == NULL) {
+        TraceLog(LOG_WARNING, "ASSETS: [%s] Failed to open asset pack", path);
+        return false;
+    }
+    if (!IsPackValid(data, size)) {
+        TraceLog(LOG_WARNING, "ASSETS: [%s] Not a valid asset pack (version %d)", path, assetPackVersion);
+        UnmapPack(data, size);
+        return false;
+    }
+
+    const AssetPackHeader *header = (const AssetPackHeader *)data;
+    const AssetEntry *entries = (const AssetEntry *)(data + header->indexOffset);
+    memset(&pack, 0, sizeof(pack));
+    pack.open = true;
+    snprintf(pack.path, sizeof(pack.path), "%s", path);
+    pack.data = data;
+    pack.size = size;
+    pack.count = (int)header->assetCount;
+    pack.slots = GAME_CALLOC((pack.count > 0) ? pack.count : 1, sizeof(AssetSlot));
+    for (int i = 0; i < pack.count; i++) pack.slots[i].entry = &entries[i];
+    pack.openTime = GetMonotonicTime();
+
+    for (int i = 0; i < assetWorkerCount; i++) pthread_create(&pack.workers[i], NULL, DecodeWorker, NULL);
+    TraceLog(LOG_INFO, "ASSETS: [%s] Streaming %d assets (%.2f MB) on %d threads", path, pack.count, size / (1024.0 * 1024.0), assetWorkerCount);
+    return true;
+}
+
+// Main thread side: GPU and audio device uploads
+static void UploadAsset(AssetSlot *slot) {
+    switch ((AssetType)slot->entry->type) {
+        case ASSET_IMAGE:
+            slot->texture = LoadTextureFromImage(slot->image);
+            UnloadImage(slot->image);
+            break;
+        case ASSET_FONT:
+            slot->font = (Font){
+                .baseSize = assetFontSize,
+                .glyphCount = fontGlyphCount,
+                .glyphPadding = fontGlyphPadding,
+                .texture = LoadTextureFromImage(slot->image),
+                .recs = slot->recs,
+                .glyphs = slot->glyphs
+            };
+            SetTextureFilter(slot->font.texture, TEXTURE_FILTER_BILINEAR);
+            UnloadImage(slot->image);
+            break;
+        case ASSET_SOUND:
+            if (IsAudioDeviceReady()) slot->sound = LoadSoundFromWave(slot->wave);
+            else TraceLog(LOG_WARNING, "ASSETS: [%s] No audio device, %s is not loaded", pack.path, slot->entry->name);
+            UnloadWave(slot->wave);
+            break;
+        case ASSET_RAW:
+        case ASSET_UNSUPPORTED:
+            break;
+    }
+    slot->image = (Image){ 0 };
+    slot->wave = (Wave){ 0 };
+}
+
+static void JoinWorkers(void) {
+    if (pack.joined) return;
+    __atomic_store_n(&pack.stopping, 1, __ATOMIC_RELAXED);
+    for (int i = 0; i < assetWorkerCount; i++) pthread_join(pack.workers[i], NULL);
+    pack.joined = true;
+}
+
+void UpdateAssetPack(double budget) {
+    if (AreAssetsLoaded()) return;
+
+    double start = GetMonotonicTime();
+    for (int i = 0; (i < pack.count) && (GetMonotonicTime() - start < budget); i++) {
+        AssetSlot *slot = &pack.slots[i];
+        int state = __atomic_load_n(&slot->state, __ATOMIC_ACQUIRE);
+        if (state == SLOT_DECODED) {
+            UploadAsset(slot);
+            slot->state = SLOT_READY;
+            pack.done++;
+        } else if (state == SLOT_FAILED) {
+            slot->state = SLOT_SKIPPED;
+            pack.done++;
+            pack.failed++;
+        }
+    }
+
+    if (pack.done == pack.count) {
+        JoinWorkers();
+        TraceLog(LOG_INFO, "ASSETS: [%s] %d assets loaded in %.1f ms, %d failed", pack.path, pack.count - pack.failed,
+                 (GetMonotonicTime() - pack.openTime) * 1000.0, pack.failed);
+    }
+}
+
+bool AreAssetsLoaded(void) {
+    return !pack.open || (pack.done == pack.count);
+}
+
+void GetAssetProgress(int *loaded, int *total) {
+    *loaded = pack.done;
+    *total = pack.count;
+}
+
+int GetAssetCount(AssetType type) {
+    int count = 0;
+    for (int i = 0; i < pack.count; i++) if (pack.slots[i].entry->type == type) count++;
+    return count;
+}
+
+void CloseAssetPack(void) {
+    if (!pack.open) return;
+    JoinWorkers();
+
+    for (int i = 0; i < pack.count; i++) {
+        AssetSlot *slot = &pack.slots[i];
+        if (slot->state == SLOT_READY) {
+            if (slot->entry->type == ASSET_IMAGE) UnloadTexture(slot->texture);
+            else if (slot->entry->type == ASSET_FONT) UnloadFont(slot->font);
+            else if ((slot->entry->type == ASSET_SOUND) && (slot->sound.frameCount > 0)) UnloadSound(slot->sound);
+        } else if (slot->state == SLOT_DECODED) {
+            // Decoded but never uploaded
+            UnloadImage(slot->image);
+            if (slot->glyphs != NULL) UnloadFontData(slot->glyphs, fontGlyphCount);
+            RL_FREE(slot->recs);
+            UnloadWave(slot->wave);
+        }
+        GAME_FREE(slot->buffer);
+    }
+
+    GAME_FREE(pack.slots);
+    UnmapPack(pack.data, pack.size);
+    memset(&pack, 0, sizeof(pack));
+}
+
+static const AssetSlot *FindAsset(const char *name, AssetType type) {
+    for (int i = 0; i < pack.count; i++) {
+        const AssetSlot *slot = &pack.slots[i];
+        if ((slot->entry->type == type) && (strcmp(slot->entry->name, name) == 0)) {
+            return (slot->state == SLOT_READY) ? slot : NULL;
+        }
+    }
+    return NULL;
+}
+
+Texture2D GetAssetTexture(const char *name) {
+    const AssetSlot *slot = FindAsset(name, ASSET_IMAGE);
+    return (slot != NULL) ? slot->texture : (Texture2D){ 0 };
+}
+
+Font GetAssetFont(const char *name) {
+    const AssetSlot *slot = FindAsset(name, ASSET_FONT);
+    return (slot != NULL) ? slot->font : GetFontDefault();
+}
+
+Sound GetAssetSound(const char *name) {
+    const AssetSlot *slot = FindAsset(name, ASSET_SOUND);
+    return (slot != NULL) ? slot->sound : (Sound){ 0 };
+}
+
+const unsigned char *GetAssetData(const char *name, int *size) {
+    const AssetSlot *slot = FindAsset(name, ASSET_RAW);
+    *size = (slot != NULL) ? (int)slot->entry->size : 0;
+    return (slot != NULL) ? slot->data : NULL;
+}
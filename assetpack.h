@@ -0,0 +1,59 @@
+#ifndef ASSETPACK_H
+#define ASSETPACK_H
+
+#include <stdbool.h>
+#include "raylib.h"
+
+// Asset packs (.pak): every texture, font and sound in one file, a header and an index followed by
+// 16 byte aligned blobs, each stored raw or deflated (sdefl/sinfl, bundled with raylib). The pack is
+// mapped, worker threads decompress and decode (PNG, TTF, WAV...) straight out of the mapping and the
+// main thread only does the GPU uploads, a few per frame, so screens stay interactive while it streams.
+// Build packs with asset_pack; the asset type comes from the file extension.
+
+#define assetPackMagic 0x50414b42u      // "BKAP"
+#define assetPackVersion 1
+#define assetNameLength 48
+#define assetBlobAlignment 16
+#define assetFontSize 32                // Fonts are rasterized once, at this size
+#define assetWorkerCount 2
+
+typedef enum AssetType {
+    ASSET_RAW,              // Bytes handed out as they are, e.g. level files
+    ASSET_IMAGE,            // Uploaded as a Texture2D
+    ASSET_FONT,             // Rasterized into an atlas on a worker, uploaded as a Font
+    ASSET_SOUND,            // Decoded to a Wave on a worker, uploaded as a Sound (call InitAudioDevice before UpdateAssetPack)
+    ASSET_UNSUPPORTED       // Image, font or sound format raylib was built without, never packed
+} AssetType;
+
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    unsigned int assetCount;
+    unsigned int indexOffset;   // AssetEntry array, right after the header
+} AssetPackHeader;
+
+typedef struct {
+    char name[assetNameLength]; // File name the asset was packed from, extension included
+    unsigned int type;          // AssetType
+    unsigned int compressed;    // Blob is a raw deflate stream
+    unsigned int offset;        // From the start of the file, assetBlobAlignment aligned
+    unsigned int packedSize;    // Blob bytes in the file
+    unsigned int size;          // Bytes once decompressed
+    unsigned int reserved;
+} AssetEntry;
+
+AssetType GetAssetTypeFromName(const char *name);  // From the extension and the file formats raylib was built with
+
+bool OpenAssetPack(const char *path);       // Maps the pack and starts decoding on worker threads, no window needed yet
+void UpdateAssetPack(double budget);        // Main thread, after InitWindow: GPU uploads for decoded assets until budget seconds are spent
+bool AreAssetsLoaded(void);                 // True once everything is uploaded, or when no pack is open
+void GetAssetProgress(int *loaded, int *total);
+int GetAssetCount(AssetType type);          // Assets of that type in the open pack
+void CloseAssetPack(void);                  // Stops the workers and unloads every asset
+
+Texture2D GetAssetTexture(const char *name);    // Id 0 until it is uploaded
+Font GetAssetFont(const char *name);            // raylib's default font until it is uploaded
+Sound GetAssetSound(const char *name);          // Empty until it is uploaded
+const unsigned char *GetAssetData(const char *name, int *size);  // ASSET_RAW bytes, NULL until decompressed
+
+#endif
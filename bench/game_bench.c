@@ -0,0 +1,326 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../embedded_levels.h"
+#include "../game.h"
+#include "../particles.h"
+#include "../perfcounters.h"
+#include "../stats.h"
+#include "../timing.h"
+
+// Headless benchmarks of the simulation hot paths on scripted input, on the built-in layout
+// at the --size grid; fill ratios are varied at runtime. --filter takes a comma separated list.
+// The level switch benchmarks start the first embedded level, from the executable or from a
+// .lvl file written next to the JSON results (the working directory without --json).
+// Usage: game_bench [--size RxC] [--samples N] [--warmup N] [--json file] [--hw] [--filter name,...]
+
+#define benchSeed 12345u
+#define benchDeltaTime (1.0f / 60.0f)
+#define episodeTickLimit (60 * 600)
+#define maxResults 32
+#define switchLevelFile "bench_switch.lvl"
+
+typedef struct {
+    const char *name;
+    float fill;
+    int iterations;         // Operations per timed sample
+    SampleStats stats;      // Nanoseconds per operation
+    double ticksPerSecond;  // Episodes only
+    double hwPerOp[HW_COUNTER_COUNT];   // Hardware counter totals per operation (--hw)
+    bool hwValid[HW_COUNTER_COUNT];
+} BenchResult;
+
+static BenchResult results[maxResults];
+static int resultCount = 0;
+
+static float currentFill = 1.0f;
+static GameSnapshot midGameSnapshot;
+static int scriptTick = 0;
+static long episodeTicks = 0;
+static bool hwCounters = false;
+static const char *filter = NULL;
+
+// Paddle chases the ball with a slowly drifting offset so the bounce angles keep changing
+static GameInput ScriptedInput() {
+    float offset = sinf(scriptTick * 0.05f) * 30.0f;
+    float target = gameState.mainBall.position.x + offset;
+    float center = gameState.paddle.x + gameState.paddle.width / 2;
+    scriptTick++;
+    return (GameInput){ target < center - 4, target > center + 4 };
+}
+
+static void ApplyFillRatio(float fill) {
+    int rows = gameState.layout.rows, columns = gameState.layout.columns;
+    srand(benchSeed);
+    gameState.blocksRemaining = 0;
+    for (int i = 0; i < rows; i++) {
+        for (int j = 0; j < columns; j++) {
+            Block *block = GetBlock(i, j);
+            block->visible = ((float)rand() / RAND_MAX) < fill;
+            if (block->visible) gameState.blocksRemaining++;
+        }
+    }
+
+    // An empty grid would end every episode on the first tick
+    if (gameState.blocksRemaining == 0) {
+        GetBlock(rows - 1, columns - 1)->visible = true;
+        gameState.blocksRemaining = 1;
+    }
+}
+
+static void StartLevel() {
+    InitGameState(benchSeed);
+    ApplyFillRatio(currentFill);
+    currentScreen = GAME;
+    scriptTick = 0;
+}
+
+static void RestoreMidGame() {
+    RestoreGameSnapshot(&midGameSnapshot);
+    currentScreen = GAME;
+    scriptTick = 0;
+    ClearParticles();
+}
+
+static void RunTicks() {
+    for (int i = 0; i < 100 && currentScreen == GAME; i++) UpdateGame(benchDeltaTime, ScriptedInput());
+}
+
+// Ball parked between the grid and the paddle, so the scan never hits and the state never changes
+static void ParkBall() {
+    RestoreMidGame();
+    gameState.mainBall.position = (Vector2){ gameState.layout.width / 2, gameState.layout.height - 100 };
+}
+
+static void RunCollisionScans() {
+    for (int i = 0; i < 1000; i++) CheckBlockCollisions();
+}
+
+static volatile bool clearCheckSink;
+
+static void RunClearChecks() {
+    for (int i = 0; i < 1000; i++) clearCheckSink = AreAllBlocksDestroyed();
+}
+
+static void NoSetup() {
+}
+
+// Restart to first frame: drop the level, build the next one and run its first tick
+static void RunRestarts() {
+    for (int i = 0; i < 10; i++) {
+        InitGameState(benchSeed + i);
+        currentScreen = GAME;
+        UpdateGame(benchDeltaTime, (GameInput){ 0 });
+    }
+}
+
+static Level switchLevel;
+static char switchLevelPath[1024];
+
+// Level switch with the level compiled in: point at the table, then build the first frame
+static void RunEmbeddedSwitches() {
+    for (int i = 0; i < 10; i++) {
+        LoadLevelFromMemory(&switchLevel, embeddedLevels[0].data, embeddedLevels[0].size);
+        SetGameLevel(&switchLevel);
+        InitGameState(benchSeed + i);
+        currentScreen = GAME;
+    }
+}
+
+// The same level from storage: open and map the file, build, unmap
+static void RunFileSwitches() {
+    for (int i = 0; i < 10; i++) {
+        LoadLevelFile(&switchLevel, switchLevelPath);
+        SetGameLevel(&switchLevel);
+        InitGameState(benchSeed + i);
+        currentScreen = GAME;
+        SetGameLevel(NULL);
+        UnloadLevelFile(&switchLevel);
+    }
+}
+
+static bool PrepareSwitchLevelFile(const char *jsonPath) {
+    const char *slash = (jsonPath != NULL) ? strrchr(jsonPath, '/') : NULL;
+    if (slash != NULL) snprintf(switchLevelPath, sizeof(switchLevelPath), "%.*s/%s", (int)(slash - jsonPath), jsonPath, switchLevelFile);
+    else snprintf(switchLevelPath, sizeof(switchLevelPath), "%s", switchLevelFile);
+
+    Level level;
+    if ((embeddedLevelCount == 0) || !LoadLevelFromMemory(&level, embeddedLevels[0].data, embeddedLevels[0].size)) return false;
+    return SaveLevelFile(switchLevelPath, level.header->rows, level.header->columns, level.header->cellWidth, level.header->cellHeight,
+                         level.health, level.types);
+}
+
+static void RunEpisode() {
+    int ticks = 0;
+    while (currentScreen == GAME && ticks < episodeTickLimit) {
+        UpdateGame(benchDeltaTime, ScriptedInput());
+        ticks++;
+    }
+    episodeTicks += ticks;
+}
+
+static bool IsSelected(const char *name) {
+    if (filter == NULL) return true;
+
+    size_t length = strlen(name);
+    const char *entry = filter;
+    while (*entry != '\0') {
+        size_t entryLength = strcspn(entry, ",");
+        if ((entryLength == length) && !strncmp(entry, name, length)) return true;
+        entry += entryLength;
+        if (*entry == ',') entry++;
+    }
+    return false;
+}
+
+static void RunBenchmark(const char *name, void (*setup)(void), void (*run)(void), int iterations, int warmup, int samples) {
+    if (!IsSelected(name)) return;
+
+    double *times = malloc(samples * sizeof(double));
+    double totalSeconds = 0.0;
+    HwSample hwTotal = { 0 };
+    episodeTicks = 0;
+
+    for (int i = -warmup; i < samples; i++) {
+        setup();
+        if (i == 0) episodeTicks = 0;
+
+        HwSample hwStart = hwCounters ? ReadHwCounters() : hwTotal;
+        double start = GetMonotonicTime();
+        run();
+        double elapsed = GetMonotonicTime() - start;
+
+        if (i >= 0) {
+            times[i] = elapsed * 1e9 / iterations;
+            totalSeconds += elapsed;
+
+            if (hwCounters) {
+                HwSample delta = SubtractHwSamples(ReadHwCounters(), hwStart);
+                for (int c = 0; c < HW_COUNTER_COUNT; c++) {
+                    hwTotal.values[c] += delta.values[c];
+                    hwTotal.valid[c] = delta.valid[c];
+                }
+            }
+        }
+    }
+
+    BenchResult *result = &results[resultCount++];
+    result->name = name;
+    result->fill = currentFill;
+    result->iterations = iterations;
+    result->stats = ComputeSampleStats(times, samples);
+    result->ticksPerSecond = (episodeTicks > 0) ? episodeTicks / totalSeconds : 0.0;
+    for (int c = 0; c < HW_COUNTER_COUNT; c++) {
+        result->hwPerOp[c] = hwTotal.values[c] / ((double)samples * iterations);
+        result->hwValid[c] = hwTotal.valid[c];
+    }
+
+    printf("%-16s fill %.2f  median %12.1f ns  p99 %12.1f ns  min %12.1f ns", name, currentFill,
+           result->stats.median, result->stats.p99, result->stats.min);
+    if (result->ticksPerSecond > 0) printf("  %.0f ticks/s", result->ticksPerSecond);
+    printf("\n");
+
+    if (result->hwValid[HW_CYCLES] && result->hwValid[HW_INSTRUCTIONS]) {
+        printf("%-16s           cycles %10.0f  instr %10.0f  IPC %.2f", "", result->hwPerOp[HW_CYCLES], result->hwPerOp[HW_INSTRUCTIONS],
+               (result->hwPerOp[HW_CYCLES] > 0.0) ? result->hwPerOp[HW_INSTRUCTIONS] / result->hwPerOp[HW_CYCLES] : 0.0);
+        if (result->hwValid[HW_CACHE_MISSES]) printf("  cache miss %.1f", result->hwPerOp[HW_CACHE_MISSES]);
+        if (result->hwValid[HW_BRANCH_MISSES]) printf("  br miss %.1f", result->hwPerOp[HW_BRANCH_MISSES]);
+        printf("  (per op)\n");
+    }
+
+    free(times);
+}
+
+static void WriteHwJson(FILE *file, const BenchResult *r, HwCounter counter) {
+    if (r->hwValid[counter]) fprintf(file, "%.1f", r->hwPerOp[counter]);
+    else fprintf(file, "null");
+}
+
+static void WriteJson(const char *path, int samples, int warmup) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) {
+        fprintf(stderr, "game_bench: cannot write %s\n", path);
+        return;
+    }
+
+    int rows, columns;
+    GetDefaultLevelSize(&rows, &columns);
+    fprintf(file, "{\n  \"suite\": \"game_bench\",\n  \"level\": \"%dx%d\",\n  \"samples\": %d,\n  \"warmup\": %d,\n  \"unit\": \"ns/op\",\n  \"results\": [\n",
+            rows, columns, samples, warmup);
+    for (int i = 0; i < resultCount; i++) {
+        const BenchResult *r = &results[i];
+        fprintf(file, "    { \"name\": \"%s\", \"fill\": %.2f, \"iterations\": %d, \"min\": %.1f, \"mean\": %.1f, \"median\": %.1f, \"p95\": %.1f, \"p99\": %.1f, \"max\": %.1f, \"ticks_per_second\": %.0f",
+                r->name, r->fill, r->iterations, r->stats.min, r->stats.mean, r->stats.median, r->stats.p95, r->stats.p99, r->stats.max,
+                r->ticksPerSecond);
+        for (int c = 0; c < HW_COUNTER_COUNT; c++) {
+            fprintf(file, ", \"%s\": ", GetHwCounterName(c));
+            WriteHwJson(file, r, c);
+        }
+        fprintf(file, " }%s\n", (i + 1 < resultCount) ? "," : "");
+    }
+    fprintf(file, "  ]\n}\n");
+    fclose(file);
+}
+
+int main(int argc, char *argv[]) {
+    int samples = 200;
+    int warmup = 20;
+    const char *jsonPath = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--samples") && (i + 1 < argc)) samples = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--warmup") && (i + 1 < argc)) warmup = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--json") && (i + 1 < argc)) jsonPath = argv[++i];
+        else if (!strcmp(argv[i], "--hw")) hwCounters = true;
+        else if (!strcmp(argv[i], "--filter") && (i + 1 < argc)) filter = argv[++i];
+        else if (!strcmp(argv[i], "--size") && (i + 1 < argc)) {
+            int rows = 0, columns = 0;
+            if (sscanf(argv[++i], "%dx%d", &rows, &columns) == 2) SetDefaultLevelSize(rows, columns);
+        }
+    }
+
+    if (hwCounters && !InitHwCounters()) {
+        printf("game_bench: hardware counters unavailable (perf_event_paranoid or container policy), timing only\n");
+        hwCounters = false;
+    }
+
+    const float fills[] = { 1.0f, 0.5f, 0.1f };
+
+    int rows, columns;
+    GetDefaultLevelSize(&rows, &columns);
+    printf("game_bench: level %dx%d, %d samples after %d warmup\n", rows, columns, samples, warmup);
+
+    for (int f = 0; f < (int)(sizeof(fills) / sizeof(fills[0])); f++) {
+        currentFill = fills[f];
+
+        // Mid-game snapshot: ball in flight after two seconds of scripted play
+        StartLevel();
+        for (int i = 0; i < 120 && currentScreen == GAME; i++) UpdateGame(benchDeltaTime, ScriptedInput());
+        SaveGameSnapshot(&midGameSnapshot);
+
+        RunBenchmark("tick", RestoreMidGame, RunTicks, 100, warmup, samples);
+        RunBenchmark("collision_scan", ParkBall, RunCollisionScans, 1000, warmup, samples);
+        RunBenchmark("clear_check", RestoreMidGame, RunClearChecks, 1000, warmup, samples);
+        RunBenchmark("episode", StartLevel, RunEpisode, 1, warmup / 4, samples / 4);
+    }
+
+    // Level size only, the fill ratio does not change what a restart does
+    currentFill = 1.0f;
+    RunBenchmark("restart", NoSetup, RunRestarts, 10, warmup, samples);
+
+    if (PrepareSwitchLevelFile(jsonPath)) {
+        RunBenchmark("switch_embedded", NoSetup, RunEmbeddedSwitches, 10, warmup, samples);
+        RunBenchmark("switch_file", NoSetup, RunFileSwitches, 10, warmup, samples);
+        remove(switchLevelPath);
+    }
+    SetGameLevel(NULL);
+
+    UnloadGameSnapshot(&midGameSnapshot);
+    UnloadLevel();
+
+    if (jsonPath != NULL) WriteJson(jsonPath, samples, warmup);
+    if (hwCounters) CloseHwCounters();
+
+    return 0;
+}
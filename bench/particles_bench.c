@@ -0,0 +1,42 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "../particles.h"
+#include "../timing.h"
+#include "../stats.h"
+
+// Keeps the pool topped up at the target live count and times UpdateParticles alone
+// Usage: particles_bench [liveParticles] [frames]
+
+#define budgetMs 1.0
+
+int main(int argc, char *argv[]) {
+    int live = (argc > 1) ? atoi(argv[1]) : 50000;
+    int frames = (argc > 2) ? atoi(argv[2]) : 2000;
+    const int warmupFrames = 100;
+    const float deltaTime = 1.0f / 60.0f;
+
+    double *times = malloc(frames * sizeof(double));
+
+    for (int frame = -warmupFrames; frame < frames; frame++) {
+        int missing = live - GetParticleCount();
+        while (missing > 0) {
+            int burst = (missing < 64) ? missing : 64;
+            EmitParticles((Vector2){ 400, 240 }, burst, YELLOW);
+            missing -= burst;
+        }
+
+        double start = GetMonotonicTime();
+        UpdateParticles(deltaTime);
+        double elapsed = GetMonotonicTime() - start;
+
+        if (frame >= 0) times[frame] = elapsed * 1000.0;
+    }
+
+    SampleStats stats = ComputeSampleStats(times, frames);
+
+    printf("particles_bench: %d live, %d frames: median %.4f ms, p99 %.4f ms, max %.4f ms (budget %.1f ms)\n",
+           live, frames, stats.median, stats.p99, stats.max, budgetMs);
+
+    free(times);
+    return (stats.p99 <= budgetMs) ? 0 : 1;
+}
@@ -0,0 +1,378 @@
+#include "blackbox.h"
+#include "allocator.h"
+#include "particles.h"
+#include "replay.h"
+#include "timing.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define stateBytesPerLine 32
+
+enum { DUMP_IDLE, DUMP_WRITING, DUMP_ABANDONED };
+
+// One hitch window handed to a detached writer thread. The main thread only fills it while idle; a
+// level start during a write abandons it to the writer, which frees it when done
+typedef struct {
+    int state;
+    char path[512];
+    float budget;
+    BlackBoxFrame window[blackBoxFrameCapacity];
+    int windowCount;
+    BlackBoxKeyframe keyframe;
+    unsigned long long hash;
+    long long hitchFrame;
+    float hitchTime;
+} DumpJob;
+
+typedef struct {
+    bool enabled;
+    float budget;
+    char directory[256];
+
+    // Written by the main thread only, no locks on the recording path
+    BlackBoxFrame frames[blackBoxFrameCapacity];    // Frame n lives at n % capacity
+    long long frameCount;
+    BlackBoxKeyframe keyframes[blackBoxKeyframeCapacity];
+    int keyframeCount;
+    BlackBoxFrame current;
+    double lastFrameEnd;
+
+    DumpJob *job;                   // Sized at level start, outside the GAME no-allocation zone
+    int writers;                    // Writer threads still running, abandoned jobs included
+
+    int dumps;
+    int skipped;
+} BlackBox;
+
+static BlackBox blackBox = { 0 };
+
+static const char *inputNames[4] = { "--", "L-", "-R", "LR" };
+
+static const char *GetInputName(GameInput input) {
+    return inputNames[(input.left ? 1 : 0) + (input.right ? 2 : 0)];
+}
+
+void InitBlackBox(float budgetMs, const char *directory) {
+    blackBox.enabled = true;
+    blackBox.budget = budgetMs;
+    snprintf(blackBox.directory, sizeof(blackBox.directory), "%s", (directory != NULL) ? directory : ".");
+    TraceLog(LOG_INFO, "BLACKBOX: Dumping GAME frames over %.1f ms to %s", budgetMs, blackBox.directory);
+}
+
+static void FreeDumpJob(DumpJob *job) {
+    UnloadGameSnapshot(&job->keyframe.snapshot);
+    GAME_FREE(job);
+}
+
+void CloseBlackBox(void) {
+    // Writers are detached, let the last dumps reach the disk before exiting
+    while (__atomic_load_n(&blackBox.writers, __ATOMIC_ACQUIRE) > 0) {
+        struct timespec wait = { 0, 1000000 };
+        nanosleep(&wait, NULL);
+    }
+
+    for (int i = 0; i < blackBoxKeyframeCapacity; i++) UnloadGameSnapshot(&blackBox.keyframes[i].snapshot);
+    if (blackBox.job != NULL) FreeDumpJob(blackBox.job);
+    blackBox.job = NULL;
+
+    if (blackBox.dumps + blackBox.skipped > 0) {
+        TraceLog(LOG_INFO, "BLACKBOX: %d hitch dumps written, %d skipped while a dump was in progress", blackBox.dumps, blackBox.skipped);
+    }
+}
+
+bool IsBlackBoxEnabled(void) {
+    return blackBox.enabled;
+}
+
+void BlackBoxLevelStart(void) {
+    if (!blackBox.enabled) return;
+
+    // Snapshots are sized here, outside the GAME no-allocation zone. A job still being written keeps
+    // its snapshot size, so it goes to the writer and the next dump gets a fresh one
+    if (blackBox.job != NULL) {
+        int writing = DUMP_WRITING;
+        if (__atomic_compare_exchange_n(&blackBox.job->state, &writing, DUMP_ABANDONED, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) blackBox.job = NULL;
+    }
+    if (blackBox.job == NULL) blackBox.job = GAME_CALLOC(1, sizeof(DumpJob));
+    for (int i = 0; i < blackBoxKeyframeCapacity; i++) ReserveGameSnapshot(&blackBox.keyframes[i].snapshot);
+    ReserveGameSnapshot(&blackBox.job->keyframe.snapshot);
+
+    blackBox.frameCount = 0;
+    blackBox.keyframeCount = 0;
+    blackBox.lastFrameEnd = 0.0;
+}
+
+void BlackBoxRecordTick(float deltaTime, GameInput input) {
+    if (!blackBox.enabled) return;
+
+    BlackBoxFrame empty = { 0 };
+    blackBox.current = empty;
+    blackBox.current.frame = blackBox.frameCount;
+    blackBox.current.deltaTime = deltaTime;
+    blackBox.current.input = input;
+
+    if (blackBox.frameCount % blackBoxKeyframeInterval == 0) {
+        BlackBoxKeyframe *keyframe = &blackBox.keyframes[blackBox.keyframeCount % blackBoxKeyframeCapacity];
+        keyframe->frame = blackBox.frameCount;
+        SaveGameSnapshot(&keyframe->snapshot);
+        keyframe->particleRandomState = GetParticleRandomState();
+        blackBox.keyframeCount++;
+    }
+}
+
+void BlackBoxRecordLateInput(float deltaTime, GameInput input) {
+    blackBox.current.lateDeltaTime = deltaTime;
+    blackBox.current.lateInput = input;
+}
+
+static void WriteHexLines(FILE *file, const char *tag, const void *data, size_t size) {
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < size; i += stateBytesPerLine) {
+        fprintf(file, "%s ", tag);
+        for (size_t j = i; (j < i + stateBytesPerLine) && (j < size); j++) fprintf(file, "%02x", bytes[j]);
+        fprintf(file, "\n");
+    }
+}
+
+static void *WriteDump(void *arg) {
+    DumpJob *job = arg;
+    FILE *file = fopen(job->path, "w");
+
+    if (file != NULL) {
+        fprintf(file, "# Block Kuzushi hitch dump, replay with: replay_test --hitch <file>\n");
+        fprintf(file, "version %d\nlevel %dx%d\nbudget %.2f\nhitch %lld %.2f\nkeyframe %lld %08x\n", blackBoxFormatVersion,
+                job->keyframe.snapshot.state.layout.rows, job->keyframe.snapshot.state.layout.columns, job->budget, job->hitchFrame, job->hitchTime, job->keyframe.frame,
+                job->keyframe.particleRandomState);
+
+        WriteHexLines(file, "state", &job->keyframe.snapshot.state, sizeof(GameState));
+        WriteHexLines(file, "arena", job->keyframe.snapshot.levelData, job->keyframe.snapshot.levelDataSize);
+
+        fprintf(file, "# frame <n> <dt> <input> <late dt> <late input> <frame ms>");
+#if PROFILER_ENABLED
+        for (int zone = 0; zone < ZONE_COUNT; zone++) fprintf(file, " <%s ms>", GetProfileZoneName(zone));
+        for (int counter = 0; counter < COUNTER_COUNT; counter++) fprintf(file, " <%s>", GetCounterName(counter));
+#endif
+        fprintf(file, "\n");
+
+        for (int i = 0; i < job->windowCount; i++) {
+            const BlackBoxFrame *frame = &job->window[i];
+            fprintf(file, "frame %lld %a %s %a %s %.3f", frame->frame, frame->deltaTime, GetInputName(frame->input),
+                    frame->lateDeltaTime, GetInputName(frame->lateInput), frame->frameTime);
+#if PROFILER_ENABLED
+            for (int zone = 0; zone < ZONE_COUNT; zone++) fprintf(file, " %.3f", frame->zoneTimes[zone]);
+            for (int counter = 0; counter < COUNTER_COUNT; counter++) fprintf(file, " %lld", frame->counters[counter]);
+#endif
+            fprintf(file, "\n");
+        }
+        fprintf(file, "end %016llx\n", job->hash);
+        fclose(file);
+    } else {
+        TraceLog(LOG_WARNING, "BLACKBOX: Cannot write %s", job->path);
+    }
+
+    if (__atomic_exchange_n(&job->state, DUMP_IDLE, __ATOMIC_ACQ_REL) == DUMP_ABANDONED) FreeDumpJob(job);
+    __atomic_fetch_sub(&blackBox.writers, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+// Copies the window on the main thread (a few tens of KB) and leaves formatting and disk I/O to a
+// detached writer thread; the main thread never waits for it, a hitch during a write is skipped
+static void DumpWindow(float frameTime) {
+    DumpJob *job = blackBox.job;
+    if ((job == NULL) || (__atomic_load_n(&job->state, __ATOMIC_ACQUIRE) != DUMP_IDLE)) {
+        blackBox.skipped++;
+        return;
+    }
+
+    long long hitchFrame = blackBox.frameCount - 1;
+    long long oldestFrame = (blackBox.frameCount > blackBoxFrameCapacity) ? blackBox.frameCount - blackBoxFrameCapacity : 0;
+
+    // Replay starts at the oldest snapshot whose following frames are all still in the ring
+    long long keyframeFrame = (oldestFrame + blackBoxKeyframeInterval - 1) / blackBoxKeyframeInterval * blackBoxKeyframeInterval;
+    if (keyframeFrame > hitchFrame) keyframeFrame -= blackBoxKeyframeInterval;
+    const BlackBoxKeyframe *keyframe = &blackBox.keyframes[(keyframeFrame / blackBoxKeyframeInterval) % blackBoxKeyframeCapacity];
+    job->keyframe.frame = keyframe->frame;
+    job->keyframe.particleRandomState = keyframe->particleRandomState;
+    job->keyframe.snapshot.state = keyframe->snapshot.state;
+    memcpy(job->keyframe.snapshot.levelData, keyframe->snapshot.levelData, keyframe->snapshot.levelDataSize);
+
+    job->windowCount = 0;
+    for (long long frame = oldestFrame; frame <= hitchFrame; frame++) {
+        job->window[job->windowCount++] = blackBox.frames[frame % blackBoxFrameCapacity];
+    }
+    job->budget = blackBox.budget;
+    job->hash = HashGameState();
+    job->hitchFrame = hitchFrame;
+    job->hitchTime = frameTime;
+    snprintf(job->path, sizeof(job->path), "%s/hitch_%ld_%lld.txt", blackBox.directory, (long)time(NULL), hitchFrame);
+
+    __atomic_store_n(&job->state, DUMP_WRITING, __ATOMIC_RELEASE);
+    __atomic_fetch_add(&blackBox.writers, 1, __ATOMIC_ACQ_REL);
+    pthread_t writer;
+    pthread_attr_t attributes;
+    pthread_attr_init(&attributes);
+    pthread_attr_setdetachstate(&attributes, PTHREAD_CREATE_DETACHED);
+    bool started = (pthread_create(&writer, &attributes, WriteDump, job) == 0);
+    pthread_attr_destroy(&attributes);
+    if (!started) {
+        __atomic_store_n(&job->state, DUMP_IDLE, __ATOMIC_RELEASE);
+        __atomic_fetch_sub(&blackBox.writers, 1, __ATOMIC_RELEASE);
+        return;
+    }
+
+    blackBox.dumps++;
+    TraceLog(LOG_WARNING, "BLACKBOX: Frame %lld took %.1f ms (budget %.1f ms), dumping %d frames to %s",
+             hitchFrame, frameTime, blackBox.budget, job->windowCount, job->path);
+}
+
+void BlackBoxFrameEnd(bool skipCheck) {
+    if (!blackBox.enabled) return;
+
+    double now = GetMonotonicTime();
+    BlackBoxFrame *frame = &blackBox.current;
+    frame->frameTime = (blackBox.lastFrameEnd > 0.0) ? (float)((now - blackBox.lastFrameEnd) * 1000.0) : 0.0f;
+    blackBox.lastFrameEnd = now;
+
+#if PROFILER_ENABLED
+    for (int zone = 0; zone < ZONE_COUNT; zone++) frame->zoneTimes[zone] = GetLastZoneTime(zone);
+    CounterSample counters = GetLastCounterSample();
+    for (int counter = 0; counter < COUNTER_COUNT; counter++) frame->counters[counter] = counters.values[counter];
+#endif
+
+    blackBox.frames[blackBox.frameCount % blackBoxFrameCapacity] = *frame;
+    blackBox.frameCount++;
+
+    if (!skipCheck && (frame->frameTime > blackBox.budget)) DumpWindow(frame->frameTime);
+}
+
+static bool ParseInput(const char *text, GameInput *input) {
+    if ((strlen(text) != 2) || ((text[0] != 'L') && (text[0] != '-')) || ((text[1] != 'R') && (text[1] != '-'))) return false;
+    *input = (GameInput){ text[0] == 'L', text[1] == 'R' };
+    return true;
+}
+
+static bool ParseFrame(const char *line, BlackBoxFrame *frame) {
+    char input[8], lateInput[8];
+    int consumed = 0;
+
+    if (sscanf(line, "frame %lld %a %7s %a %7s %f%n", &frame->frame, &frame->deltaTime, input, &frame->lateDeltaTime,
+               lateInput, &frame->frameTime, &consumed) != 6) return false;
+    if (!ParseInput(input, &frame->input) || !ParseInput(lateInput, &frame->lateInput)) return false;
+
+    // Zone times are only present when the recording build had the profiler compiled in
+    const char *cursor = line + consumed;
+    for (int zone = 0; zone < ZONE_COUNT; zone++) {
+        char *next;
+        frame->zoneTimes[zone] = strtof(cursor, &next);
+        if (next == cursor) break;
+        cursor = next;
+    }
+    return true;
+}
+
+bool LoadBlackBoxDump(BlackBoxDump *dump, const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        TraceLog(LOG_WARNING, "BLACKBOX: Cannot open %s", path);
+        return false;
+    }
+
+    BlackBoxDump empty = { 0 };
+    *dump = empty;
+    dump->frames = GAME_MALLOC(blackBoxFrameCapacity * sizeof(BlackBoxFrame));
+
+    char line[512];
+    bool valid = true;
+    bool ended = false;
+    size_t stateBytes = 0;
+    size_t arenaBytes = 0;
+    int rows = 0, columns = 0;
+    GameSnapshot *snapshot = &dump->keyframe.snapshot;
+    while (valid && !ended && (fgets(line, sizeof(line), file) != NULL)) {
+        int version;
+        BlackBoxFrame frame = { 0 };
+
+        if ((line[0] == '#') || (line[0] == '\n')) continue;
+        else if (sscanf(line, "version %d", &version) == 1) valid = (version == blackBoxFormatVersion);
+        else if (sscanf(line, "level %dx%d", &rows, &columns) == 2) continue;
+        else if (sscanf(line, "budget %f", &dump->budget) == 1) continue;
+        else if (sscanf(line, "hitch %lld %f", &dump->hitchFrame, &dump->hitchTime) == 2) continue;
+        else if (sscanf(line, "keyframe %lld %x", &dump->keyframe.frame, &dump->keyframe.particleRandomState) == 2) continue;
+        else if (!strncmp(line, "state ", 6)) {
+            unsigned char *state = (unsigned char *)&snapshot->state;
+            unsigned int byte;
+            for (const char *hex = line + 6; (sscanf(hex, "%2x", &byte) == 1) && valid; hex += 2) {
+                valid = (stateBytes < sizeof(GameState));
+                if (valid) state[stateBytes++] = (unsigned char)byte;
+            }
+        }
+        else if (!strncmp(line, "arena ", 6)) {
+            unsigned int byte;
+            for (const char *hex = line + 6; sscanf(hex, "%2x", &byte) == 1; hex += 2) {
+                if (arenaBytes == snapshot->levelDataSize) {
+                    snapshot->levelDataSize = (snapshot->levelDataSize > 0) ? snapshot->levelDataSize * 2 : 4096;
+                    snapshot->levelData = GAME_REALLOC(snapshot->levelData, snapshot->levelDataSize);
+                }
+                snapshot->levelData[arenaBytes++] = (unsigned char)byte;
+            }
+        }
+        else if (ParseFrame(line, &frame)) {
+            // Frames before the keyframe are timing context only
+            if (frame.frame >= dump->keyframe.frame) {
+                valid = (dump->frameCount < blackBoxFrameCapacity);
+                if (valid) dump->frames[dump->frameCount++] = frame;
+            }
+        }
+        else if (sscanf(line, "end %llx", &dump->finalHash) == 1) ended = true;
+        else valid = false;
+    }
+    fclose(file);
+    snapshot->levelDataSize = arenaBytes;
+
+    // The snapshot is raw GameState memory, so it only loads into the same build
+    if (valid && (stateBytes != sizeof(GameState))) {
+        TraceLog(LOG_WARNING, "BLACKBOX: %s: state snapshot has %zu bytes, this build expects %zu", path, stateBytes, sizeof(GameState));
+        valid = false;
+    }
+    valid = valid && (rows == snapshot->state.layout.rows) && (columns == snapshot->state.layout.columns);
+    valid = valid && ended && (dump->frameCount > 0) && (dump->frames[dump->frameCount - 1].frame == dump->hitchFrame);
+
+    if (!valid) {
+        TraceLog(LOG_WARNING, "BLACKBOX: %s is not a complete hitch dump for this build", path);
+        UnloadBlackBoxDump(dump);
+    }
+    return valid;
+}
+
+void UnloadBlackBoxDump(BlackBoxDump *dump) {
+    UnloadGameSnapshot(&dump->keyframe.snapshot);
+    GAME_FREE(dump->frames);
+    dump->frames = NULL;
+    dump->frameCount = 0;
+}
+
+bool RunBlackBoxDump(const BlackBoxDump *dump, double *tickTimes, unsigned long long *hash) {
+    if (!RestoreGameSnapshot(&dump->keyframe.snapshot)) {
+        TraceLog(LOG_WARNING, "BLACKBOX: Level arena snapshot has %zu bytes, this build lays out %zu", dump->keyframe.snapshot.levelDataSize, GetLevelDataSize());
+        return false;
+    }
+    currentScreen = GAME;
+    ClearParticles();
+    SetParticleRandomState(dump->keyframe.particleRandomState);
+
+    for (int i = 0; i < dump->frameCount; i++) {
+        const BlackBoxFrame *frame = &dump->frames[i];
+        double start = GetMonotonicTime();
+
+        UpdateGame(frame->deltaTime, frame->input);
+        if (frame->lateDeltaTime > 0.0f) UpdatePaddle(frame->lateDeltaTime, frame->lateInput);
+
+        if (tickTimes != NULL) tickTimes[i] = (GetMonotonicTime() - start) * 1000.0;
+    }
+    *hash = HashGameState();
+    return true;
+}
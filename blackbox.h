@@ -0,0 +1,57 @@
+#ifndef BLACKBOX_H
+#define BLACKBOX_H
+
+#include <stdbool.h>
+#include "game.h"
+#include "profiler.h"
+#include "counters.h"
+
+#define blackBoxFrameCapacity 300       // Five seconds of GAME frames at 60 fps
+#define blackBoxKeyframeInterval 60     // Frames between game state snapshots in the ring
+#define blackBoxKeyframeCapacity (blackBoxFrameCapacity / blackBoxKeyframeInterval + 1)
+#define blackBoxFormatVersion 3
+
+// Everything needed to replay one GAME frame, plus what it cost. Zone times and counters stay
+// zero when the profiler is compiled out; define ENABLE_PROFILER in kiosk builds to keep them
+typedef struct {
+    long long frame;                // GAME frames since the level started
+    float deltaTime;                // UpdateGame tick
+    GameInput input;
+    float lateDeltaTime;            // Low latency paddle update in DrawGame, 0 when there was none
+    GameInput lateInput;
+    float frameTime;                // Milliseconds since the previous frame end
+    float zoneTimes[ZONE_COUNT];
+    long long counters[COUNTER_COUNT];
+} BlackBoxFrame;
+
+// Game state right before the tick of `frame`; live particles are not kept, they expire long before the hitch
+typedef struct {
+    long long frame;
+    GameSnapshot snapshot;
+    unsigned int particleRandomState;
+} BlackBoxKeyframe;
+
+// A hitch dump loaded back for headless replay: the frames from the keyframe up to the hitch
+typedef struct {
+    float budget;
+    long long hitchFrame;
+    float hitchTime;
+    BlackBoxKeyframe keyframe;
+    BlackBoxFrame *frames;          // Starting at the keyframe, the hitch frame is the last one
+    int frameCount;
+    unsigned long long finalHash;   // HashGameState() at the end of the hitch frame
+} BlackBoxDump;
+
+void InitBlackBox(float budgetMs, const char *directory);   // Start watching GAME frames, dumps go to directory (NULL: working directory)
+void CloseBlackBox(void);                                   // Waits for dumps still being written
+bool IsBlackBoxEnabled(void);
+void BlackBoxLevelStart(void);                              // Forget the previous level and size the snapshots, call after InitGameState
+void BlackBoxRecordTick(float deltaTime, GameInput input);  // Call right before UpdateGame
+void BlackBoxRecordLateInput(float deltaTime, GameInput input);
+void BlackBoxFrameEnd(bool skipCheck);                      // Commit the frame, dump the window when it exceeded the budget
+
+bool LoadBlackBoxDump(BlackBoxDump *dump, const char *path); // Fails when the dump comes from another build
+void UnloadBlackBoxDump(BlackBoxDump *dump);
+bool RunBlackBoxDump(const BlackBoxDump *dump, double *tickTimes, unsigned long long *hash); // Replay from the keyframe, tickTimes[frameCount] in ms may be NULL
+
+#endif
@@ -0,0 +1,331 @@
+#include "capture.h"
+#include "allocator.h"
+#include "counters.h"
+#include "raylib.h"
+#include "rlgl.h"
+#include "timing.h"
+#include "trace.h"
+#include "external/msf_gif.h"           // Implementation is compiled into raylib (SUPPORT_GIF_RECORDING)
+#include "external/stb_image_write.h"   // Implementation is compiled into raylib (SUPPORT_IMAGE_EXPORT)
+
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Desktop OpenGL goes through the glad loader compiled into raylib, which also loads the pixel pack
+// buffer entry points rlgl does not wrap. OpenGL ES 2 (web) has no PBOs and reads back synchronously
+#if defined(GRAPHICS_API_OPENGL_33) && !defined(GRAPHICS_API_OPENGL_ES2)
+    #define CAPTURE_PBO_SUPPORTED
+    #include "external/glad.h"
+#endif
+
+#define gifMaxBitDepth 16
+#define captureReadbackCount 3          // Pixel pack buffers in flight
+#define captureReadbackLatency 2        // CaptureFrame calls between a readback and mapping its buffer
+
+typedef struct {
+    unsigned char *pixels;      // Preallocated at StartCapture, width*height*4
+    double time;
+    bool bottomUp;              // Straight from glReadPixels, the encoder flips it
+} CaptureSlot;
+
+typedef struct {
+    unsigned int buffer;        // GL_PIXEL_PACK_BUFFER
+    long frame;                 // CaptureFrame call it was issued on
+    double time;
+} CaptureReadback;
+
+typedef struct {
+    bool active;
+    CaptureFormat format;
+    char path[512];
+    double interval;
+    double lastCaptureTime;
+    int width, height;
+
+    CaptureSlot ring[captureRingSize];
+    int head;               // Next slot written by the main thread
+    int tail;               // Next slot read by the encoder
+    int queued;
+    int reserved;           // Main thread only: slots promised to readbacks still in flight
+
+    bool asyncReadback;
+    CaptureReadback readbacks[captureReadbackCount];
+    int readbackIssue;      // Next buffer to read into
+    int readbackCollect;    // Oldest buffer in flight
+    int readbacksPending;
+    long frame;
+    bool stopping;
+    double stopTime;
+    pthread_mutex_t lock;
+    pthread_cond_t wake;
+    pthread_t encoder;
+
+    FILE *gifFile;
+    MsfGifState gif;
+
+    // Stats
+    int captured;
+    int dropped;
+    int encoded;
+    double encodeSeconds;
+    size_t bytesWritten;
+} Capture;
+
+static Capture capture = { 0 };
+
+static size_t CountingWrite(const void *buffer, size_t size, size_t count, void *stream) {
+    size_t written = fwrite(buffer, size, count, (FILE *)stream);
+    capture.bytesWritten += written * size;
+    return written;
+}
+
+// glReadPixels rows start at the bottom, and the default framebuffer's alpha is not meaningful
+static void FlipFrame(unsigned char *pixels, unsigned char *row) {
+    int stride = capture.width * 4;
+    for (int y = 0; y < capture.height / 2; y++) {
+        unsigned char *top = pixels + (size_t)y * stride;
+        unsigned char *bottom = pixels + (size_t)(capture.height - 1 - y) * stride;
+        memcpy(row, top, stride);
+        memcpy(top, bottom, stride);
+        memcpy(bottom, row, stride);
+    }
+    size_t size = (size_t)stride * capture.height;
+    for (size_t i = 3; i < size; i += 4) pixels[i] = 255;
+}
+
+static void EncodeFrame(CaptureSlot *slot, double displayTime, int frameIndex) {
+    double start = GetMonotonicTime();
+
+    if (capture.format == CAPTURE_GIF) {
+        int centiSeconds = (int)(displayTime * 100.0 + 0.5);
+        if (centiSeconds < 1) centiSeconds = 1;
+        msf_gif_frame_to_file(&capture.gif, slot->pixels, centiSeconds, gifMaxBitDepth, capture.width * 4);
+    } else {
+        char fileName[600];
+        snprintf(fileName, sizeof(fileName), "%s_%06d.png", capture.path, frameIndex);
+        if (stbi_write_png(fileName, capture.width, capture.height, 4, slot->pixels, capture.width * 4)) {
+            capture.bytesWritten += (size_t)GetFileLength(fileName);
+        }
+    }
+
+    double end = GetMonotonicTime();
+    TraceComplete("encode", start, end);
+    capture.encodeSeconds += end - start;
+    capture.encoded++;
+}
+
+// GIF frame delays are only known once the next frame arrives, so the encoder waits for the frame
+// after the one it encodes (or for the stop). The slot is handed back once it has been encoded
+static void *EncoderThread(void *arg) {
+    (void)arg;
+    unsigned char *row = GAME_MALLOC((size_t)capture.width * 4);
+    TraceSetThreadName("capture encoder");
+
+    pthread_mutex_lock(&capture.lock);
+    for (;;) {
+        while ((capture.queued < 2) && !capture.stopping) pthread_cond_wait(&capture.wake, &capture.lock);
+        if (capture.queued == 0) break;
+
+        CaptureSlot *slot = &capture.ring[capture.tail];
+        double nextTime = (capture.queued > 1) ? capture.ring[(capture.tail + 1) % captureRingSize].time : capture.stopTime;
+        pthread_mutex_unlock(&capture.lock);
+
+        if (slot->bottomUp) FlipFrame(slot->pixels, row);
+        EncodeFrame(slot, nextTime - slot->time, capture.encoded);
+
+        pthread_mutex_lock(&capture.lock);
+        capture.tail = (capture.tail + 1) % captureRingSize;
+        capture.queued--;
+    }
+    pthread_mutex_unlock(&capture.lock);
+
+    GAME_FREE(row);
+    return NULL;
+}
+
+// Main thread: fills the slot reserved for this frame and hands it to the encoder
+static void QueueFrame(const unsigned char *pixels, double time, bool bottomUp) {
+    CaptureSlot *slot = &capture.ring[capture.head];
+    memcpy(slot->pixels, pixels, (size_t)capture.width * capture.height * 4);
+    slot->time = time;
+    slot->bottomUp = bottomUp;
+
+    pthread_mutex_lock(&capture.lock);
+    capture.head = (capture.head + 1) % captureRingSize;
+    capture.queued++;
+    pthread_cond_signal(&capture.wake);
+    pthread_mutex_unlock(&capture.lock);
+
+    capture.reserved--;
+    capture.captured++;
+}
+
+#if defined(CAPTURE_PBO_SUPPORTED)
+static bool InitReadbacks(void) {
+    if ((glad_glMapBufferRange == NULL) || (glad_glGenBuffers == NULL)) return false;
+
+    size_t size = (size_t)capture.width * capture.height * 4;
+    for (int i = 0; i < captureReadbackCount; i++) {
+        glGenBuffers(1, &capture.readbacks[i].buffer);
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, capture.readbacks[i].buffer);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)size, NULL, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return true;
+}
+
+// Starts copying the framebuffer into the next pixel pack buffer; glReadPixels returns without
+// waiting for the GPU, the copy is done by the time the buffer is mapped a few frames later
+static void IssueReadback(double time) {
+    CaptureReadback *readback = &capture.readbacks[capture.readbackIssue];
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->buffer);
+    glReadPixels(0, 0, capture.width, capture.height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    readback->frame = capture.frame;
+    readback->time = time;
+    capture.readbackIssue = (capture.readbackIssue + 1) % captureReadbackCount;
+    capture.readbacksPending++;
+}
+
+// Maps the readbacks that are old enough (all of them when flushing) into their ring slots
+static void CollectReadbacks(bool flush) {
+    size_t size = (size_t)capture.width * capture.height * 4;
+    while (capture.readbacksPending > 0) {
+        CaptureReadback *readback = &capture.readbacks[capture.readbackCollect];
+        if (!flush && (capture.frame - readback->frame < captureReadbackLatency)) break;
+
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, readback->buffer);
+        const unsigned char *pixels = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)size, GL_MAP_READ_BIT);
+        if (pixels != NULL) {
+            QueueFrame(pixels, readback->time, true);
+            glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        } else {
+            capture.reserved--;
+            capture.dropped++;
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+        capture.readbackCollect = (capture.readbackCollect + 1) % captureReadbackCount;
+        capture.readbacksPending--;
+    }
+}
+
+static void UnloadReadbacks(void) {
+    for (int i = 0; i < captureReadbackCount; i++) glDeleteBuffers(1, &capture.readbacks[i].buffer);
+}
+#else
+static bool InitReadbacks(void) { return false; }
+static void IssueReadback(double time) { (void)time; }
+static void CollectReadbacks(bool flush) { (void)flush; }
+static void UnloadReadbacks(void) { }
+#endif
+
+bool StartCapture(const char *path, CaptureFormat format, int fps) {
+    if (capture.active) StopCapture();
+
+    Capture fresh = { 0 };
+    capture = fresh;
+    capture.format = format;
+    TextCopy(capture.path, path);
+    capture.interval = 1.0 / ((fps > 0) ? fps : captureDefaultFPS);
+    capture.lastCaptureTime = -capture.interval;
+    capture.width = GetRenderWidth();
+    capture.height = GetRenderHeight();
+
+    if (format == CAPTURE_GIF) {
+        capture.gifFile = fopen(path, "wb");
+        if (capture.gifFile == NULL) {
+            TraceLog(LOG_WARNING, "CAPTURE: [%s] Failed to open file", path);
+            return false;
+        }
+        msf_gif_begin_to_file(&capture.gif, capture.width, capture.height, CountingWrite, capture.gifFile);
+    }
+
+    for (int i = 0; i < captureRingSize; i++) capture.ring[i].pixels = GAME_MALLOC((size_t)capture.width * capture.height * 4);
+    capture.asyncReadback = InitReadbacks();
+
+    pthread_mutex_init(&capture.lock, NULL);
+    pthread_cond_init(&capture.wake, NULL);
+    pthread_create(&capture.encoder, NULL, EncoderThread, NULL);
+    capture.active = true;
+
+    TraceLog(LOG_INFO, "CAPTURE: [%s] Recording %dx%d %s at %d fps, %s readback", path, capture.width, capture.height,
+             (format == CAPTURE_GIF) ? "GIF" : "PNG sequence", (int)(1.0 / capture.interval + 0.5),
+             capture.asyncReadback ? "asynchronous" : "synchronous");
+    return true;
+}
+
+void StopCapture(void) {
+    if (!capture.active) return;
+
+    // The last frames in flight are worth the stall
+    if (capture.asyncReadback) {
+        CollectReadbacks(true);
+        UnloadReadbacks();
+    }
+
+    pthread_mutex_lock(&capture.lock);
+    capture.stopping = true;
+    capture.stopTime = GetTime();
+    pthread_cond_signal(&capture.wake);
+    pthread_mutex_unlock(&capture.lock);
+
+    pthread_join(capture.encoder, NULL);
+    pthread_cond_destroy(&capture.wake);
+    pthread_mutex_destroy(&capture.lock);
+
+    if (capture.format == CAPTURE_GIF) {
+        msf_gif_end_to_file(&capture.gif);
+        fclose(capture.gifFile);
+    }
+    for (int i = 0; i < captureRingSize; i++) GAME_FREE(capture.ring[i].pixels);
+    capture.active = false;
+
+    double fps = (capture.encodeSeconds > 0) ? capture.encoded / capture.encodeSeconds : 0.0;
+    double megabytes = capture.bytesWritten / (1024.0 * 1024.0);
+    TraceLog(LOG_INFO, "CAPTURE: [%s] %d frames captured, %d dropped, %d encoded", capture.path, capture.captured, capture.dropped, capture.encoded);
+    TraceLog(LOG_INFO, "CAPTURE: Encoder throughput %.1f frames/s, %.2f MB written (%.2f MB/s while encoding)",
+             fps, megabytes, (capture.encodeSeconds > 0) ? megabytes / capture.encodeSeconds : 0.0);
+}
+
+void CaptureFrame(void) {
+    if (!capture.active) return;
+
+    capture.frame++;
+    if (capture.asyncReadback) CollectReadbacks(false);
+
+    double now = GetTime();
+    if (now - capture.lastCaptureTime < capture.interval) return;
+    capture.lastCaptureTime = now;
+
+    // Every frame read back owns a slot from the moment it is issued. Decide before reading back,
+    // so a dropped frame costs nothing on the main thread
+    pthread_mutex_lock(&capture.lock);
+    bool full = (capture.queued + capture.reserved >= captureRingSize);
+    pthread_mutex_unlock(&capture.lock);
+    if (full || (capture.readbacksPending == captureReadbackCount)) {
+        capture.dropped++;
+        return;
+    }
+    capture.reserved++;
+
+    COUNT_BATCH();
+    rlDrawRenderBatchActive();
+    if (capture.asyncReadback) {
+        IssueReadback(now);
+    } else {
+        // rlReadScreenPixels allocates and flips on this thread, expected while recording without PBOs
+        NO_ALLOCATIONS_SUSPEND();
+        unsigned char *pixels = rlReadScreenPixels(capture.width, capture.height);
+        NO_ALLOCATIONS_RESUME();
+        QueueFrame(pixels, now, false);
+        RL_FREE(pixels);
+    }
+}
+
+bool IsCapturing(void) {
+    return capture.active;
+}
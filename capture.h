@@ -0,0 +1,20 @@
+#ifndef CAPTURE_H
+#define CAPTURE_H
+
+#include <stdbool.h>
+
+#define captureRingSize 8
+#define captureDefaultFPS 30
+
+typedef enum CaptureFormat { CAPTURE_GIF, CAPTURE_PNG } CaptureFormat;
+
+// Recording session: the main thread starts an asynchronous readback into a pixel pack buffer and
+// copies it into a preallocated ring slot two frames later, once the GPU is done with it. A
+// background thread flips, encodes and writes the slots. When every slot is taken the frame is
+// dropped instead of stalling the game. Without PBOs (OpenGL ES 2) the readback is synchronous.
+bool StartCapture(const char *path, CaptureFormat format, int fps);  // .gif file, or file prefix for a numbered PNG sequence
+void StopCapture(void);                                             // Flush pending frames, join encoder and log stats
+void CaptureFrame(void);                                            // Call right before EndDrawing(), throttled to the capture fps
+bool IsCapturing(void);
+
+#endif
@@ -0,0 +1,55 @@
+# Two stage PGO + LTO release build. Run from the source root:
+#   cmake -P cmake/pgo_build.cmake [-DBUILD_ROOT=build-pgo] [-DCOMPARE=ON]
+# BUILD_ROOT/generate: instrumented build, runs pgo_train and writes profiles to BUILD_ROOT/pgo
+# BUILD_ROOT/release:  optimized build using those profiles, the one to ship
+# BUILD_ROOT/plain:    with COMPARE=ON, a plain Release (-O2/-O3) build trained the same way, so the
+#                      pgo_throughput.txt of both can be compared
+
+get_filename_component(SOURCE_DIR ${CMAKE_CURRENT_LIST_DIR}/.. ABSOLUTE)
+if (NOT BUILD_ROOT)
+    set(BUILD_ROOT ${SOURCE_DIR}/build-pgo)
+endif ()
+get_filename_component(BUILD_ROOT ${BUILD_ROOT} ABSOLUTE)
+set(PROFILE_DIR ${BUILD_ROOT}/pgo)
+
+function(run_step description)
+    message(STATUS "pgo_build: ${description}")
+    execute_process(COMMAND ${ARGN} RESULT_VARIABLE result)
+    if (NOT result EQUAL 0)
+        message(FATAL_ERROR "pgo_build: ${description} failed (${result})")
+    endif ()
+endfunction()
+
+function(configure_and_build directory)
+    run_step("configure ${directory}" ${CMAKE_COMMAND} -S ${SOURCE_DIR} -B ${BUILD_ROOT}/${directory} -DCMAKE_BUILD_TYPE=Release ${ARGN})
+    run_step("build ${directory}" ${CMAKE_COMMAND} --build ${BUILD_ROOT}/${directory})
+endfunction()
+
+# Stale counters from an older source tree would be merged into the new ones
+file(REMOVE_RECURSE ${PROFILE_DIR})
+configure_and_build(generate -DGAME_LTO=ON -DGAME_PGO=GENERATE -DGAME_PGO_DIR=${PROFILE_DIR})
+run_step("training" ${CMAKE_COMMAND} --build ${BUILD_ROOT}/generate --target pgo_train)
+
+# GCC reads its .gcda files directly, Clang's raw profiles have to be merged first
+file(GLOB RAW_PROFILES ${PROFILE_DIR}/*.profraw)
+if (RAW_PROFILES)
+    find_program(LLVM_PROFDATA NAMES llvm-profdata)
+    if (NOT LLVM_PROFDATA)
+        message(FATAL_ERROR "pgo_build: llvm-profdata is needed to merge the Clang profiles")
+    endif ()
+    run_step("merge profiles" ${LLVM_PROFDATA} merge -output=${PROFILE_DIR}/default.profdata ${RAW_PROFILES})
+endif ()
+
+configure_and_build(release -DGAME_LTO=ON -DGAME_PGO=USE -DGAME_PGO_DIR=${PROFILE_DIR})
+
+if (COMPARE)
+    configure_and_build(plain -DGAME_LTO=OFF -DGAME_PGO=OFF)
+    run_step("plain training run" ${CMAKE_COMMAND} --build ${BUILD_ROOT}/plain --target pgo_train)
+    run_step("optimized training run" ${CMAKE_COMMAND} --build ${BUILD_ROOT}/release --target pgo_train)
+    foreach (directory plain release)
+        file(READ ${BUILD_ROOT}/${directory}/pgo_throughput.txt throughput)
+        message(STATUS "pgo_build: ${directory} throughput\n${throughput}")
+    endforeach ()
+endif ()
+
+message(STATUS "pgo_build: optimized build in ${BUILD_ROOT}/release")
@@ -0,0 +1,133 @@
+#include "counters.h"
+#include "raylib.h"
+#include "rlgl.h"
+#include "timing.h"
+
+#include <stdio.h>
+
+static CounterSample history[counterHistorySize] = { 0 };
+static CounterSample current = { 0 };
+static int historyNext = 0;
+static int historyCount = 0;
+static long long framesRecorded = 0;
+static double lastFrameEnd = 0.0;
+
+static rlRenderBatch countedBatch = { 0 };
+static bool countedBatchLoaded = false;
+static int expectedBuffer = -1;     // Buffer rlgl moves to with the flush after CountRenderBatch, -1 at frame start
+
+static const char *counterNames[COUNTER_COUNT] = {
+    "collision_tests", "blocks_hit", "balls_active", "powerups_active",
+    "draw_calls", "batch_flushes", "vertices", "upload_bytes"
+};
+
+void CounterAdd(Counter counter, long long value) {
+    current.values[counter] += value;
+}
+
+void CounterSet(Counter counter, long long value) {
+    current.values[counter] = value;
+}
+
+void LoadCountedRenderBatch(void) {
+    countedBatch = rlLoadRenderBatch(countedBatchBuffers, RL_DEFAULT_BATCH_BUFFER_ELEMENTS);
+    rlSetRenderBatchActive(&countedBatch);
+    countedBatchLoaded = true;
+}
+
+void UnloadCountedRenderBatch(void) {
+    if (!countedBatchLoaded) return;
+    rlSetRenderBatchActive(NULL);
+    rlUnloadRenderBatch(countedBatch);
+    countedBatchLoaded = false;
+}
+
+void CountRenderBatch(void) {
+    if (!countedBatchLoaded) return;
+
+    // Every flush moves rlgl to the next buffer, so a buffer past the expected one means rlgl flushed
+    // full batches by itself since the last call (up to countedBatchBuffers - 1 of them are told apart)
+    if (expectedBuffer >= 0) {
+        int overflows = (countedBatch.currentBuffer - expectedBuffer + countedBatchBuffers) % countedBatchBuffers;
+        current.values[COUNTER_BATCH_FLUSHES] += overflows;
+        current.values[COUNTER_VERTICES] += (long long)overflows * countedBatch.vertexBuffer[0].elementCount * 4;
+    }
+
+    int vertices = 0;
+    for (int i = 0; i < countedBatch.drawCounter; i++) {
+        if (countedBatch.draws[i].vertexCount == 0) continue;
+        vertices += countedBatch.draws[i].vertexCount + countedBatch.draws[i].vertexAlignment;
+        current.values[COUNTER_DRAW_CALLS]++;
+    }
+    if (vertices > 0) current.values[COUNTER_BATCH_FLUSHES]++;
+    current.values[COUNTER_VERTICES] += vertices;
+    expectedBuffer = (countedBatch.currentBuffer + 1) % countedBatchBuffers;
+}
+
+void CountersFrameEnd(void) {
+    double now = GetMonotonicTime();
+
+    current.values[COUNTER_UPLOAD_BYTES] = current.values[COUNTER_VERTICES] * bytesPerBatchVertex;
+    expectedBuffer = -1;    // Static screens flush uncounted in between
+    current.frameTime = (lastFrameEnd > 0.0) ? (float)((now - lastFrameEnd) * 1000.0) : 0.0f;
+    lastFrameEnd = now;
+
+    history[historyNext] = current;
+    historyNext = (historyNext + 1) % counterHistorySize;
+    if (historyCount < counterHistorySize) historyCount++;
+    framesRecorded++;
+
+    CounterSample empty = { 0 };
+    current = empty;
+}
+
+CounterSample GetLastCounterSample(void) {
+    CounterSample empty = { 0 };
+    if (historyCount == 0) return empty;
+    return history[(historyNext + counterHistorySize - 1) % counterHistorySize];
+}
+
+bool ExportCounters(const char *path) {
+    if (!COUNTERS_ENABLED) {
+        TraceLog(LOG_WARNING, "COUNTERS: [%s] Not exported, counters are compiled out (DISABLE_COUNTERS)", path);
+        return false;
+    }
+
+    FILE *file = fopen(path, "w");
+    if (file == NULL) return false;
+
+    bool json = IsFileExtension(path, ".json");
+    long long firstFrame = framesRecorded - historyCount;
+
+    if (json) {
+        fprintf(file, "{\"frames\":[\n");
+    } else {
+        fprintf(file, "frame,frame_ms");
+        for (int c = 0; c < COUNTER_COUNT; c++) fprintf(file, ",%s", counterNames[c]);
+        fprintf(file, "\n");
+    }
+
+    for (int i = 0; i < historyCount; i++) {
+        const CounterSample *sample = &history[(historyNext - historyCount + i + counterHistorySize) % counterHistorySize];
+
+        if (json) {
+            fprintf(file, "{\"frame\":%lld,\"frame_ms\":%.3f", firstFrame + i, sample->frameTime);
+            for (int c = 0; c < COUNTER_COUNT; c++) fprintf(file, ",\"%s\":%lld", counterNames[c], sample->values[c]);
+            fprintf(file, "}%s\n", (i + 1 < historyCount) ? "," : "");
+        } else {
+            fprintf(file, "%lld,%.3f", firstFrame + i, sample->frameTime);
+            for (int c = 0; c < COUNTER_COUNT; c++) fprintf(file, ",%lld", sample->values[c]);
+            fprintf(file, "\n");
+        }
+    }
+
+    if (json) fprintf(file, "]}\n");
+    fclose(file);
+
+    TraceLog(LOG_INFO, "COUNTERS: [%s] %d frames exported", path, historyCount);
+    return true;
+}
+
+const char *GetCounterName(Counter counter) {
+    return counterNames[counter];
+}
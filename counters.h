@@ -0,0 +1,61 @@
+#ifndef COUNTERS_H
+#define COUNTERS_H
+
+#include <stdbool.h>
+
+#define counterHistorySize 3600     // One minute of GAME frames at 60 fps
+
+// rlgl uploads position, texcoord, normal and color for every batched vertex
+#define bytesPerBatchVertex (3 * 4 + 2 * 4 + 3 * 4 + 4)
+#define countedBatchBuffers 4       // rlgl cycles buffers on every flush, which shows its own overflow flushes
+
+typedef enum Counter {
+    COUNTER_COLLISION_TESTS,
+    COUNTER_BLOCKS_HIT,
+    COUNTER_BALLS_ACTIVE,
+    COUNTER_POWERUPS_ACTIVE,
+    // Read from the game's render batch right before each flush, overlays included. A batch rlgl
+    // flushes by itself when it is full counts as a flush of a full buffer, its draws are not seen
+    COUNTER_DRAW_CALLS,         // GPU draws: one per texture or primitive mode run in a flushed batch
+    COUNTER_BATCH_FLUSHES,      // Batches that drew something
+    COUNTER_VERTICES,           // Vertices uploaded, alignment padding included
+    COUNTER_UPLOAD_BYTES,       // Vertex data uploaded for the vertices above
+    COUNTER_COUNT
+} Counter;
+
+typedef struct {
+    long long values[COUNTER_COUNT];
+    float frameTime;            // Milliseconds since the previous sample
+} CounterSample;
+
+// Counters are a few adds per frame, so unlike the profiler zones they stay in Release builds.
+// Define DISABLE_COUNTERS to compile them out; ExportCounters then refuses instead of writing zeros
+#if !defined(DISABLE_COUNTERS)
+    #define COUNTERS_ENABLED 1
+#else
+    #define COUNTERS_ENABLED 0
+#endif
+
+#if COUNTERS_ENABLED
+    #define COUNTER_ADD(counter, value) CounterAdd(counter, value)
+    #define COUNTER_SET(counter, value) CounterSet(counter, value)
+    #define COUNT_BATCH() CountRenderBatch()
+    #define COUNTERS_FRAME_END() CountersFrameEnd()
+#else
+    #define COUNTER_ADD(counter, value) ((void)0)
+    #define COUNTER_SET(counter, value) ((void)0)
+    #define COUNT_BATCH() ((void)0)
+    #define COUNTERS_FRAME_END() ((void)0)
+#endif
+
+void CounterAdd(Counter counter, long long value);
+void CounterSet(Counter counter, long long value);
+void LoadCountedRenderBatch(void);              // Make a game owned batch the active one, call after InitWindow
+void UnloadCountedRenderBatch(void);            // Back to raylib's batch, call before CloseWindow
+void CountRenderBatch(void);                    // Call right before anything that flushes the batch (render target, mode, EndDrawing)
+void CountersFrameEnd(void);                    // Commit the frame to the ring
+bool ExportCounters(const char *path);          // CSV, or JSON when the file name ends in .json
+CounterSample GetLastCounterSample(void);       // Last committed frame, all zero before the first one
+const char *GetCounterName(Counter counter);
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef EMBEDDED_LEVELS_H
+#define EMBEDDED_LEVELS_H
+
+// Levels compiled into the executable: the build runs `level_convert --embed` over levels/*.txt
+// and links the generated table. Each entry holds the bytes of a .lvl file, ready for
+// LoadLevelFromMemory, so starting one involves no file access and no parsing.
+
+typedef struct {
+    const char *name;               // Source file name without extension
+    const unsigned char *data;      // 16 byte aligned
+    unsigned int size;
+} EmbeddedLevel;
+
+extern const EmbeddedLevel embeddedLevels[];
+extern const int embeddedLevelCount;
+
+#endif
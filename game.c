@@ -0,0 +1,415 @@
+#include <math.h>
+#include <string.h>
+#include "game.h"
+#include "allocator.h"
+#include "levelgen.h"
+#include "particles.h"
+#include "profiler.h"
+#include "counters.h"
+
+// Room for the block grid plus the allocator's block header and alignment
+#define levelArenaSlack 256
+
+GameState gameState;
+GameScreen currentScreen = MENU;
+Block *levelBlocks = NULL;
+
+static Arena levelArena = { 0 };
+static const Level *activeLevel = NULL;
+static LevelGenParams generatorParams;
+static bool generatorActive = false;
+static int defaultRows = blockRowCount;
+static int defaultColumns = blocksPerRow;
+static GameSnapshot levelTemplate = { 0 };  // Initial state of the selected level, every restart copies it
+static bool templateValid = false;
+
+// Same LCG as the C library's reference rand(), but the state lives in gameState so a snapshot resumes the same sequence
+static int GameRandom(void) {
+    gameState.randomState = gameState.randomState * 1103515245u + 12345u;
+    return (int)((gameState.randomState >> 16) & 0x7fff);
+}
+
+// The previous level is dropped by resetting the arena, which only grows when a bigger grid comes along.
+// Allocations happen in the same order every time, so a level's arena contents can be copied over another one's
+static void AllocateLevel(int rows, int columns) {
+    size_t blockBytes = (size_t)rows * columns * sizeof(Block);
+    if (levelArena.capacity < blockBytes + levelArenaSlack) {
+        FreeArena(&levelArena);
+        InitArena(&levelArena, blockBytes + levelArenaSlack);
+    }
+    ResetArena(&levelArena);
+
+    BeginArenaAllocations(&levelArena);
+    levelBlocks = GAME_MALLOC(blockBytes);
+    EndArenaAllocations();
+}
+
+void UnloadLevel(void) {
+    FreeArena(&levelArena);
+    levelBlocks = NULL;
+    UnloadGameSnapshot(&levelTemplate);
+    templateValid = false;
+}
+
+size_t GetLevelDataSize(void) {
+    return levelArena.used;
+}
+
+bool SetGameLevel(const Level *level) {
+    if ((level != NULL) && ((level->header->rows > maxGridDimension) || (level->header->columns > maxGridDimension))) {
+        TraceLog(LOG_WARNING, "LEVEL: Level is %dx%d, grids are limited to %dx%d",
+                 level->header->rows, level->header->columns, maxGridDimension, maxGridDimension);
+        return false;
+    }
+    activeLevel = level;
+    generatorActive = false;
+    templateValid = false;
+    return true;
+}
+
+bool SetGameLevelGenerator(const LevelGenParams *params) {
+    if ((params->rows < 1) || (params->rows > maxGridDimension) || (params->columns < 1) || (params->columns > maxGridDimension)) {
+        TraceLog(LOG_WARNING, "LEVEL: Generated levels are limited to %dx%d, not %dx%d",
+                 maxGridDimension, maxGridDimension, params->rows, params->columns);
+        return false;
+    }
+    generatorParams = *params;
+    generatorActive = true;
+    activeLevel = NULL;
+    templateValid = false;
+    return true;
+}
+
+const Level *GetGameLevel(void) {
+    return activeLevel;
+}
+
+bool GetGameLevelGenerator(LevelGenParams *params) {
+    if (generatorActive) *params = generatorParams;
+    return generatorActive;
+}
+
+void SetDefaultLevelSize(int rows, int columns) {
+    defaultRows = (rows < 1) ? 1 : (rows > maxGridDimension) ? maxGridDimension : rows;
+    defaultColumns = (columns < 1) ? 1 : (columns > maxGridDimension) ? maxGridDimension : columns;
+    templateValid = false;
+}
+
+void GetDefaultLevelSize(int *rows, int *columns) {
+    *rows = defaultRows;
+    *columns = defaultColumns;
+}
+
+static LevelLayout MakeLayout(int rows, int columns, float cellWidth, float cellHeight) {
+    LevelLayout layout = { .rows = rows, .columns = columns, .cellWidth = cellWidth, .cellHeight = cellHeight };
+    layout.width = fmaxf(screenWidth, columns * (cellWidth + blockGapX));
+    layout.height = fmaxf(screenHeight, gridTop + rows * (cellHeight + blockGapY) - blockGapY + gridPlaySpace);
+    return layout;
+}
+
+static void SetBlock(Block *block, int health) {
+    block->visible = (health > 0);
+    block->health = (unsigned char)health;
+}
+
+static void PlaceFlashingBlock(int row, int column) {
+    gameState.flashingBlock.rect = GetBlockRect(row, column);
+    gameState.flashingBlock.visible = true;
+}
+
+// Built-in layout: a full grid with the flashing block over the top center, the seed adds the health upgrades
+static void BuildDefaultBlocks(void) {
+    int rows = defaultRows, columns = defaultColumns;
+    float width = fmaxf(screenWidth / columns - blockGapX, minBlockWidth);
+    gameState.layout = MakeLayout(rows, columns, width, blockHeight);
+    AllocateLevel(rows, columns);
+
+    for (int i = 0; i < rows * columns; i++) SetBlock(&levelBlocks[i], 1);
+    gameState.blocksRemaining = rows * columns;
+
+    PlaceFlashingBlock(0, columns / 2);
+}
+
+// The only seeded part of a level, applied on top of the template
+static void AddRandomUpgrades(void) {
+    int rows = gameState.layout.rows, columns = gameState.layout.columns;
+    for (int k = 0; k < 5; k++) {
+        int i = GameRandom() % rows;
+        int j = GameRandom() % columns;
+        if ((i != rows / 2) || (j != columns / 2)) { // Ensure it doesn't replace the flashing block
+            GetBlock(i, j)->health = (GameRandom() % 2) + 2;  // Randomly assign 2 or 3 health
+        }
+    }
+}
+
+// Straight from the mapped arrays, the first flashing cell becomes the flashing block
+static void BuildLevelBlocks(const Level *level) {
+    const LevelHeader *header = level->header;
+    float width = (header->cellWidth > 0) ? header->cellWidth : fmaxf(screenWidth / header->columns - blockGapX, minBlockWidth);
+    float height = (header->cellHeight > 0) ? header->cellHeight : blockHeight;
+    gameState.layout = MakeLayout(header->rows, header->columns, width, height);
+    AllocateLevel(header->rows, header->columns);
+
+    int cells = header->rows * header->columns;
+    gameState.blocksRemaining = 0;
+    gameState.flashingBlock.visible = false;
+    for (int cell = 0; cell < cells; cell++) {
+        bool normal = (level->types[cell] == BLOCK_NORMAL);
+        SetBlock(&levelBlocks[cell], normal ? level->health[cell] : 0);
+        if (levelBlocks[cell].visible) gameState.blocksRemaining++;
+
+        if ((level->types[cell] == BLOCK_FLASHING) && !gameState.flashingBlock.visible) {
+            PlaceFlashingBlock(cell / header->columns, cell % header->columns);
+        }
+    }
+}
+
+// Each cell is generated in place, there is no intermediate level
+static void BuildGeneratedBlocks(const LevelGenParams *params) {
+    float width = fmaxf(screenWidth / params->columns - blockGapX, minBlockWidth);
+    gameState.layout = MakeLayout(params->rows, params->columns, width, blockHeight);
+    AllocateLevel(params->rows, params->columns);
+
+    gameState.blocksRemaining = 0;
+    gameState.flashingBlock.visible = false;
+    for (int i = 0; i < params->rows; i++) {
+        for (int j = 0; j < params->columns; j++) {
+            unsigned char health, type;
+            GenerateLevelCell(params, i, j, &health, &type);
+            SetBlock(GetBlock(i, j), (type == BLOCK_NORMAL) ? health : 0);
+            if (GetBlock(i, j)->visible) gameState.blocksRemaining++;
+            if ((type == BLOCK_FLASHING) && !gameState.flashingBlock.visible) PlaceFlashingBlock(i, j);
+        }
+    }
+}
+
+// Everything a restart resets that does not depend on the seed
+static void BuildLevelTemplate(void) {
+    if (activeLevel != NULL) BuildLevelBlocks(activeLevel);
+    else if (generatorActive) BuildGeneratedBlocks(&generatorParams);
+    else BuildDefaultBlocks();
+
+    gameState.lives = 1;
+    gameState.paddle = (Rectangle){ gameState.layout.width / 2 - 50, gameState.layout.height - 50, 100, 20 };
+
+    gameState.mainBall.position = (Vector2){ gameState.paddle.x + gameState.paddle.width / 2, gameState.paddle.y - ballRadius * 2 };
+    gameState.mainBall.speedX = 0;
+    gameState.mainBall.speedY = 0;
+    gameState.mainBall.active = false;
+
+    gameState.ballStartDelay = 1.0f;
+    gameState.ballDelayed = true;
+
+    gameState.resetTimer = 0;
+    gameState.isResetting = false;
+
+    gameState.elapsedTime = 0;
+
+    gameState.powerUp.position = (Vector2){0, 0};
+    gameState.powerUp.active = false;
+
+    SaveGameSnapshot(&levelTemplate);
+    templateValid = true;
+}
+
+void InitGameState(unsigned int seed) {
+    if (!templateValid) BuildLevelTemplate();
+    else RestoreGameSnapshot(&levelTemplate);
+
+    gameState.randomState = seed;
+    if ((activeLevel == NULL) && !generatorActive) AddRandomUpgrades();
+
+    ClearParticles();
+}
+
+void UpdatePaddle(float deltaTime, GameInput input) {
+    if (input.left) gameState.paddle.x -= paddleSpeed * deltaTime;
+    if (input.right) gameState.paddle.x += paddleSpeed * deltaTime;
+    if (gameState.paddle.x < 0) gameState.paddle.x = 0;
+    if (gameState.paddle.x + gameState.paddle.width > gameState.layout.width) gameState.paddle.x = gameState.layout.width - gameState.paddle.width;
+}
+
+void ResetBall() {
+    gameState.mainBall.position = (Vector2){ gameState.paddle.x + gameState.paddle.width / 2, gameState.paddle.y - ballRadius * 2 };
+    gameState.mainBall.speedX = 0;
+    gameState.mainBall.speedY = 0;
+    gameState.isResetting = false;
+    //wait
+    gameState.ballStartDelay = 1.0f;
+    gameState.ballDelayed = true;
+}
+
+
+
+Color GetBlockColor(int health) {
+    return (health == 1) ? YELLOW : (health == 2) ? RED : BLUE;
+}
+
+static Vector2 GetRectCenter(Rectangle rect) {
+    return (Vector2){ rect.x + rect.width / 2, rect.y + rect.height / 2 };
+}
+
+BlockRange GetBlockRange(Rectangle area) {
+    const LevelLayout *layout = &gameState.layout;
+    float pitchX = layout->cellWidth + blockGapX;
+    float pitchY = layout->cellHeight + blockGapY;
+
+    // A cell starts at index * pitch + offset and is narrower than the pitch, so the cell starting
+    // at or before each edge is the first or last one that can reach into the area
+    BlockRange range = {
+        .firstRow = (int)floorf((area.y - gridTop) / pitchY),
+        .lastRow = (int)floorf((area.y + area.height - gridTop) / pitchY),
+        .firstColumn = (int)floorf((area.x - gridLeft) / pitchX),
+        .lastColumn = (int)floorf((area.x + area.width - gridLeft) / pitchX)
+    };
+    if (range.firstRow < 0) range.firstRow = 0;
+    if (range.lastRow > layout->rows - 1) range.lastRow = layout->rows - 1;
+    if (range.firstColumn < 0) range.firstColumn = 0;
+    if (range.lastColumn > layout->columns - 1) range.lastColumn = layout->columns - 1;
+    return range;
+}
+
+bool AreAllBlocksDestroyed() {
+    return gameState.blocksRemaining <= 0;
+}
+
+void CheckBlockCollisions() {
+    Vector2 ball = gameState.mainBall.position;
+    BlockRange range = GetBlockRange((Rectangle){ ball.x - ballRadius, ball.y - ballRadius, ballRadius * 2, ballRadius * 2 });
+
+    int tests = 0;
+    for (int i = range.firstRow; i <= range.lastRow; i++) {
+        for (int j = range.firstColumn; j <= range.lastColumn; j++) {
+            Block *block = GetBlock(i, j);
+            if (!block->visible) continue;
+            tests++;
+            Rectangle rect = GetBlockRect(i, j);
+            if (CheckCollisionCircleRec(ball, ballRadius, rect)) {
+                COUNTER_ADD(COUNTER_BLOCKS_HIT, 1);
+                EmitParticles(GetRectCenter(rect), hitParticleCount, GetBlockColor(block->health));
+                block->health--;
+                if (block->health <= 0) {
+                    block->visible = false;
+                    gameState.blocksRemaining--;
+                }
+                gameState.mainBall.speedY *= -1;
+            }
+        }
+    }
+    COUNTER_ADD(COUNTER_COLLISION_TESTS, tests);
+}
+
+void UpdateGame(float deltaTime, GameInput input) {
+    UpdateParticles(deltaTime);
+    gameState.elapsedTime += deltaTime;
+
+    if (gameState.isResetting) {
+        gameState.resetTimer -= deltaTime;
+        if (gameState.resetTimer <= 0) {
+            ResetBall();
+        }
+    }
+
+    if (gameState.ballDelayed) {
+        gameState.ballStartDelay -= deltaTime;
+        if (gameState.ballStartDelay <= 0) {
+            gameState.mainBall.speedX = (GameRandom() % 201) - 100;
+            gameState.mainBall.speedY = -500;
+            gameState.mainBall.active = true;
+            gameState.ballDelayed = false;
+        }
+    }
+
+    UpdatePaddle(deltaTime, input);
+
+    if (!gameState.isResetting && !gameState.ballDelayed) {
+        gameState.mainBall.position.x += gameState.mainBall.speedX * deltaTime;
+        gameState.mainBall.position.y += gameState.mainBall.speedY * deltaTime;
+
+        if (gameState.mainBall.position.x < ballRadius || gameState.mainBall.position.x > gameState.layout.width - ballRadius) {
+            gameState.mainBall.speedX *= -1;
+        }
+
+        if (gameState.mainBall.position.y < ballRadius) {
+            gameState.mainBall.speedY *= -1;
+        }
+
+        if (gameState.mainBall.position.y >= gameState.layout.height - 30 && !gameState.isResetting) {
+            gameState.lives--;
+            if (gameState.lives > 0) {
+                ResetBall();
+            } else {
+                currentScreen = GAME_OVER;
+            }
+        }
+
+        if (CheckCollisionCircleRec(gameState.mainBall.position, ballRadius, gameState.paddle)) {
+            gameState.mainBall.speedY = -fabsf(gameState.mainBall.speedY);
+            gameState.mainBall.speedX = (gameState.mainBall.position.x - (gameState.paddle.x + gameState.paddle.width / 2)) / (gameState.paddle.width / 2) * 250;
+        }
+
+        PROFILE_BEGIN(ZONE_COLLISION);
+        CheckBlockCollisions();
+        PROFILE_END(ZONE_COLLISION);
+
+        // Paddle, flashing block and power-up pickup tests
+        COUNTER_ADD(COUNTER_COLLISION_TESTS, 1 + gameState.flashingBlock.visible + gameState.powerUp.active);
+
+        if (gameState.flashingBlock.visible && CheckCollisionCircleRec(gameState.mainBall.position, ballRadius, gameState.flashingBlock.rect)) {
+            gameState.flashingBlock.visible = false;
+            COUNTER_ADD(COUNTER_BLOCKS_HIT, 1);
+            EmitParticles(GetRectCenter(gameState.flashingBlock.rect), hitParticleCount, GREEN);
+            gameState.powerUp.position = (Vector2){ gameState.flashingBlock.rect.x + gameState.flashingBlock.rect.width / 2, gameState.flashingBlock.rect.y };
+            gameState.powerUp.active = true;
+            gameState.mainBall.speedY *= -1;
+        }
+
+        if (gameState.powerUp.active) {
+            gameState.powerUp.position.y += 200 * deltaTime;
+            if (gameState.powerUp.position.y >= gameState.layout.height) {
+                gameState.powerUp.active = false;
+            }
+        }
+
+        // PowerCollect
+        if (gameState.powerUp.active && CheckCollisionCircleRec(gameState.powerUp.position, ballRadius, gameState.paddle)) {
+            gameState.lives++;
+            gameState.powerUp.active = false;
+        }
+
+        if (AreAllBlocksDestroyed()) {
+            currentScreen = WIN;
+        }
+    }
+}
+
+void ReserveGameSnapshot(GameSnapshot *snapshot) {
+    if (snapshot->levelDataSize == GetLevelDataSize()) return;
+
+    GAME_FREE(snapshot->levelData);
+    snapshot->levelDataSize = GetLevelDataSize();
+    snapshot->levelData = GAME_MALLOC(snapshot->levelDataSize);
+}
+
+void SaveGameSnapshot(GameSnapshot *snapshot) {
+    ReserveGameSnapshot(snapshot);
+    snapshot->state = gameState;
+    memcpy(snapshot->levelData, levelArena.base, snapshot->levelDataSize);
+}
+
+bool RestoreGameSnapshot(const GameSnapshot *snapshot) {
+    // Lay the arena out for the snapshot's grid first, it may come from another level or process
+    const LevelLayout *layout = &snapshot->state.layout;
+    if ((levelArena.base == NULL) || (snapshot->levelDataSize != GetLevelDataSize())) AllocateLevel(layout->rows, layout->columns);
+    if (snapshot->levelDataSize != GetLevelDataSize()) return false;
+
+    gameState = snapshot->state;
+    memcpy(levelArena.base, snapshot->levelData, snapshot->levelDataSize);
+    return true;
+}
+
+void UnloadGameSnapshot(GameSnapshot *snapshot) {
+    GAME_FREE(snapshot->levelData);
+    snapshot->levelData = NULL;
+    snapshot->levelDataSize = 0;
+}
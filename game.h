@@ -0,0 +1,134 @@
+#ifndef GAME_H
+#define GAME_H
+
+#include <stddef.h>
+#include "raylib.h"
+#include "level.h"
+#include "levelgen.h"
+
+typedef enum GameScreen { MENU, GAME, WIN, GAME_OVER } GameScreen;
+
+#define screenWidth 800
+#define screenHeight 480
+#define blocksPerRow 10             // Built-in layout size, see SetDefaultLevelSize
+#define blockRowCount 5
+#define blockHeight 20
+#define minBlockWidth 20            // Built-in layouts with many columns grow wider than the screen instead
+#define blockGapX 20
+#define blockGapY 10
+#define gridLeft 10
+#define gridTop 40
+#define gridPlaySpace 300           // Below the last row, down to the bottom of the field
+#define maxGridDimension 1000
+#define ballRadius 10
+#define hitParticleCount 24
+#define paddleSpeed 400
+
+// One grid cell. Its rectangle follows from the row, column and layout (GetBlockRect), so a
+// cell takes 2 bytes of level arena: about 2 MB for a 1000x1000 grid
+typedef struct {
+    bool visible;
+    unsigned char health;
+} Block;
+
+typedef struct {
+    Rectangle rect;
+    bool visible;
+} FlashingBlock;
+
+// Grid and play field size of the current level; the field is the screen unless the grid needs more room
+typedef struct {
+    int rows;
+    int columns;
+    float cellWidth;
+    float cellHeight;
+    float width;
+    float height;
+} LevelLayout;
+
+typedef struct {
+    Vector2 position;
+    float speedX, speedY;
+    bool active;
+} Ball;
+
+typedef struct {
+    Vector2 position;
+    bool active;
+} PowerUp;
+
+typedef struct {
+    LevelLayout layout;
+    Rectangle paddle;
+    int lives;
+    Ball mainBall;
+    FlashingBlock flashingBlock;
+    bool flashingBlockVisible;
+    PowerUp powerUp;
+    float resetTimer;
+    bool isResetting;
+    float ballStartDelay;
+    bool ballDelayed;
+    int blocksRemaining;
+    float elapsedTime;
+    unsigned int randomState;   // Block health and serve angles, part of the state so snapshots replay exactly
+} GameState;
+
+// Paddle controls for one tick, read from the keyboard by the game or scripted by headless tools
+typedef struct {
+    bool left;
+    bool right;
+} GameInput;
+
+// Game state plus a copy of the level arena, so saving or restoring one is two memcpys
+typedef struct {
+    GameState state;
+    unsigned char *levelData;
+    size_t levelDataSize;
+} GameSnapshot;
+
+extern GameState gameState;
+extern GameScreen currentScreen;
+
+// Per-level data lives in one arena that InitGameState resets in O(1) before building the next level
+extern Block *levelBlocks;      // layout.rows rows of layout.columns blocks
+
+static inline Block *GetBlock(int row, int column) {
+    return &levelBlocks[row * gameState.layout.columns + column];
+}
+
+static inline Rectangle GetBlockRect(int row, int column) {
+    const LevelLayout *layout = &gameState.layout;
+    return (Rectangle){ column * (layout->cellWidth + blockGapX) + gridLeft, row * (layout->cellHeight + blockGapY) + gridTop,
+                        layout->cellWidth, layout->cellHeight };
+}
+
+// Cells whose rectangles may overlap the area, clamped to the grid; empty when first > last
+typedef struct {
+    int firstRow, lastRow;
+    int firstColumn, lastColumn;
+} BlockRange;
+
+bool SetGameLevel(const Level *level);              // Layout for the next InitGameState, NULL for the built-in one; the level must outlive its use
+bool SetGameLevelGenerator(const LevelGenParams *params); // Generate every following level from these parameters, until SetGameLevel
+const Level *GetGameLevel(void);                    // Level given to SetGameLevel, NULL for the built-in layout or a generator
+bool GetGameLevelGenerator(LevelGenParams *params); // False unless levels come from SetGameLevelGenerator
+void SetDefaultLevelSize(int rows, int columns);    // Grid of the built-in layout, blockRowCount x blocksPerRow until changed
+void GetDefaultLevelSize(int *rows, int *columns);
+BlockRange GetBlockRange(Rectangle area);           // O(1), for work that only concerns blocks near something
+void InitGameState(unsigned int seed);              // Reset the level by copying its prebuilt initial state, seed drives the random block health and serve angles
+void ResetBall(void);
+void UpdatePaddle(float deltaTime, GameInput input);
+void CheckBlockCollisions(void);                    // Ball against the blocks around it
+bool AreAllBlocksDestroyed(void);                   // O(1), from blocksRemaining
+void UpdateGame(float deltaTime, GameInput input);  // One simulation tick, no rendering or window access
+Color GetBlockColor(int health);
+void UnloadLevel(void);                             // Release the level arena and the restart template
+size_t GetLevelDataSize(void);                      // Bytes of the level arena in use
+
+void ReserveGameSnapshot(GameSnapshot *snapshot);   // Size the buffer for the current level, so saving into it never allocates
+void SaveGameSnapshot(GameSnapshot *snapshot);
+bool RestoreGameSnapshot(const GameSnapshot *snapshot); // Fails when the snapshot comes from a different level layout
+void UnloadGameSnapshot(GameSnapshot *snapshot);
+
+#endif
@@ -0,0 +1,71 @@
+#include "hud.h"
+#include "counters.h"
+
+static HudField fields[hudMaxFields] = { 0 };
+static int fieldCount = 0;
+
+int AddHudField(const char *label, const int *value, HudValueType type, Vector2 position, int fontSize, Color color, bool alignRight) {
+    if (fieldCount == hudMaxFields) return -1;
+
+    HudField *field = &fields[fieldCount];
+    field->label = label;
+    field->value = value;
+    field->type = type;
+    field->dirty = true;
+    field->visible = true;
+    field->alignRight = alignRight;
+    field->position = position;
+    field->fontSize = fontSize;
+    field->color = color;
+    field->texture = LoadRenderTexture(hudFieldMaxWidth, fontSize);
+
+    return fieldCount++;
+}
+
+void SetHudFieldVisible(int field, bool visible) {
+    fields[field].visible = visible;
+}
+
+static void RenderHudField(HudField *field) {
+    int value = *field->value;
+    const char *text = (field->type == HUD_CLOCK) ? TextFormat("%s: %d:%02d", field->label, value / 60, value % 60)
+                                                 : TextFormat("%s: %d", field->label, value);
+
+    field->textWidth = MeasureText(text, field->fontSize);
+    if (field->textWidth > hudFieldMaxWidth) field->textWidth = hudFieldMaxWidth;
+
+    COUNT_BATCH();
+    BeginTextureMode(field->texture);
+    ClearBackground(BLANK);
+    DrawText(text, 0, 0, field->fontSize, field->color);
+    COUNT_BATCH();
+    EndTextureMode();
+
+    field->lastValue = value;
+    field->dirty = false;
+}
+
+void UpdateHud(void) {
+    for (int i = 0; i < fieldCount; i++) {
+        if (fields[i].visible && (fields[i].dirty || (*fields[i].value != fields[i].lastValue))) RenderHudField(&fields[i]);
+    }
+}
+
+void DrawHud(void) {
+    for (int i = 0; i < fieldCount; i++) {
+        const HudField *field = &fields[i];
+        if (!field->visible || field->dirty) continue;
+
+        Vector2 position = field->position;
+        if (field->alignRight) position.x -= field->textWidth;
+
+        // Render textures are stored bottom-up, hence the negative source height
+        Rectangle source = { 0, 0, (float)field->textWidth, -(float)field->texture.texture.height };
+        DrawTextureRec(field->texture.texture, source, position, WHITE);
+    }
+}
+
+void UnloadHud(void) {
+    for (int i = 0; i < fieldCount; i++) UnloadRenderTexture(fields[i].texture);
+    fieldCount = 0;
+}
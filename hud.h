@@ -0,0 +1,34 @@
+#ifndef HUD_H
+#define HUD_H
+
+#include "raylib.h"
+
+#define hudMaxFields 8
+#define hudFieldMaxWidth 240
+
+typedef enum HudValueType { HUD_NUMBER, HUD_CLOCK } HudValueType;
+
+// A HUD text element bound to an int. Its text is formatted and rendered into a small
+// render texture only when the value changes; every other frame it is one textured quad.
+typedef struct {
+    const char *label;
+    const int *value;
+    HudValueType type;
+    int lastValue;
+    bool dirty;
+    bool visible;
+    bool alignRight;
+    Vector2 position;
+    int fontSize;
+    Color color;
+    int textWidth;
+    RenderTexture2D texture;
+} HudField;
+
+int AddHudField(const char *label, const int *value, HudValueType type, Vector2 position, int fontSize, Color color, bool alignRight);
+void SetHudFieldVisible(int field, bool visible);
+void UpdateHud(void);       // Re-render changed fields, call outside of any texture mode
+void DrawHud(void);
+void UnloadHud(void);
+
+#endif
@@ -0,0 +1,250 @@
+#include "level.h"
+#include "allocator.h"
+#include "raylib.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+_Static_assert(sizeof(LevelHeader) == 32, "level header layout is part of the file format");
+
+#if !defined(_WIN32)
+static void *MapFile(const char *path, size_t *size) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat info;
+    void *data = NULL;
+    if ((fstat(fd, &info) == 0) && (info.st_size > 0)) {
+        data = mmap(NULL, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) data = NULL;
+        else *size = (size_t)info.st_size;
+    }
+    close(fd);      // The mapping keeps the file referenced
+    return data;
+}
+
+static void UnmapFile(void *data, size_t size) {
+    munmap(data, size);
+}
+#else
+// No mmap here: read the file once, the rest of the code does not know the difference
+static void *MapFile(const char *path, size_t *size) {
+    FILE *file = fopen(path, "rb");
+    if (file == NULL) return NULL;
+
+    void *data = NULL;
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fseek(file, 0, SEEK_SET);
+    if (length > 0) {
+        data = GAME_MALLOC((size_t)length);
+        if ((data != NULL) && (fread(data, 1, (size_t)length, file) != (size_t)length)) {
+            GAME_FREE(data);
+            data = NULL;
+        }
+        else *size = (size_t)length;
+    }
+    fclose(file);
+    return data;
+}
+
+static void UnmapFile(void *data, size_t size) {
+    (void)size;
+    GAME_FREE(data);
+}
+#endif
+
+static bool IsArrayInFile(unsigned int offset, size_t cells, size_t fileSize) {
+    return (offset >= sizeof(LevelHeader)) && (offset <= fileSize) && (cells <= fileSize - offset);
+}
+
+// Header and array bounds only, the cells themselves are never scanned
+static bool OpenLevel(Level *level, const void *data, size_t size, const char *name) {
+    const LevelHeader *header = data;
+    bool valid = (size >= sizeof(LevelHeader)) && (header->magic == levelMagic);
+    if (!valid) TraceLog(LOG_WARNING, "LEVEL: [%s] Not a level file", name);
+    else if (header->version != levelFormatVersion) {
+        TraceLog(LOG_WARNING, "LEVEL: [%s] Format version %u, expected %d", name, header->version, levelFormatVersion);
+        valid = false;
+    }
+    else if ((header->rows < 1) || (header->rows > levelMaxDimension) || (header->columns < 1) || (header->columns > levelMaxDimension)) {
+        TraceLog(LOG_WARNING, "LEVEL: [%s] Invalid grid size %dx%d", name, header->rows, header->columns);
+        valid = false;
+    }
+    else {
+        size_t cells = (size_t)header->rows * header->columns;
+        valid = IsArrayInFile(header->healthOffset, cells, size) && IsArrayInFile(header->typeOffset, cells, size);
+        if (!valid) TraceLog(LOG_WARNING, "LEVEL: [%s] Truncated level file", name);
+    }
+    if (!valid) return false;
+
+    level->header = header;
+    level->health = (const unsigned char *)data + header->healthOffset;
+    level->types = (const unsigned char *)data + header->typeOffset;
+    level->data = data;
+    level->dataSize = size;
+    return true;
+}
+
+bool LoadLevelFile(Level *level, const char *path) {
+    memset(level, 0, sizeof(Level));
+
+    size_t size = 0;
+    void *data = MapFile(path, &size);
+    if (data == NULL) {
+        TraceLog(LOG_WARNING, "LEVEL: [%s] Failed to open level file", path);
+        return false;
+    }
+
+    if (!OpenLevel(level, data, size, path)) {
+        UnmapFile(data, size);
+        return false;
+    }
+    level->mapped = true;
+    return true;
+}
+
+bool LoadLevelFromMemory(Level *level, const void *data, size_t size) {
+    memset(level, 0, sizeof(Level));
+    return OpenLevel(level, data, size, "memory");
+}
+
+void UnloadLevelFile(Level *level) {
+    if (level->mapped) UnmapFile((void *)level->data, level->dataSize);
+    memset(level, 0, sizeof(Level));
+}
+
+// The exact bytes of a .lvl file, so files and embedded levels share one layout
+static unsigned char *PackLevel(int rows, int columns, float cellWidth, float cellHeight,
+                                const unsigned char *health, const unsigned char *types, size_t *size) {
+    size_t cells = (size_t)rows * columns;
+    LevelHeader header = {
+        .magic = levelMagic,
+        .version = levelFormatVersion,
+        .rows = rows,
+        .columns = columns,
+        .cellWidth = cellWidth,
+        .cellHeight = cellHeight,
+        .healthOffset = sizeof(LevelHeader),
+        .typeOffset = (unsigned int)(sizeof(LevelHeader) + cells)
+    };
+
+    *size = sizeof(LevelHeader) + 2 * cells;
+    unsigned char *data = GAME_MALLOC(*size);
+    if (data == NULL) return NULL;
+
+    memcpy(data, &header, sizeof(header));
+    memcpy(data + header.healthOffset, health, cells);
+    memcpy(data + header.typeOffset, types, cells);
+    return data;
+}
+
+static bool WriteLevelData(const char *path, const unsigned char *data, size_t size) {
+    FILE *file = fopen(path, "wb");
+    if (file == NULL) {
+        TraceLog(LOG_WARNING, "LEVEL: [%s] Failed to open file for writing", path);
+        return false;
+    }
+
+    bool written = (fwrite(data, 1, size, file) == size);
+    written = (fclose(file) == 0) && written;
+    if (!written) TraceLog(LOG_WARNING, "LEVEL: [%s] Failed to write level file", path);
+    return written;
+}
+
+bool SaveLevelFile(const char *path, int rows, int columns, float cellWidth, float cellHeight,
+                   const unsigned char *health, const unsigned char *types) {
+    size_t size = 0;
+    unsigned char *data = PackLevel(rows, columns, cellWidth, cellHeight, health, types, &size);
+    bool written = (data != NULL) && WriteLevelData(path, data, size);
+    GAME_FREE(data);
+    return written;
+}
+
+// One character per cell: '.' empty, '1'-'9' a block with that much health, 'F' the flashing block
+static bool ParseCell(char cell, unsigned char *health, unsigned char *type) {
+    if (cell == '.') {
+        *health = 0;
+        *type = BLOCK_EMPTY;
+    } else if ((cell >= '1') && (cell <= '9')) {
+        *health = (unsigned char)(cell - '0');
+        *type = BLOCK_NORMAL;
+    } else if (cell == 'F') {
+        *health = 1;
+        *type = BLOCK_FLASHING;
+    } else return false;
+    return true;
+}
+
+unsigned char *PackLevelText(const char *textPath, size_t *size) {
+    FILE *file = fopen(textPath, "r");
+    if (file == NULL) {
+        TraceLog(LOG_WARNING, "LEVEL: [%s] Failed to open level source", textPath);
+        return NULL;
+    }
+
+    char line[levelMaxDimension + 2];
+    int lineNumber = 0;
+    int rows = 0, columns = 0;
+    float cellWidth = 0, cellHeight = 0;
+    unsigned char *health = NULL, *types = NULL;
+    size_t capacity = 0;
+    bool valid = true;
+
+    while (valid && (fgets(line, sizeof(line), file) != NULL)) {
+        lineNumber++;
+        size_t length = strlen(line);
+        while ((length > 0) && ((line[length - 1] == '\n') || (line[length - 1] == '\r') || (line[length - 1] == ' ') || (line[length - 1] == '\t'))) line[--length] = '\0';
+
+        if ((length == 0) || (line[0] == '#')) continue;
+        if (sscanf(line, "cell %f %f", &cellWidth, &cellHeight) == 2) continue;
+
+        if (columns == 0) columns = (int)length;
+        if (((int)length != columns) || (columns > levelMaxDimension) || (rows == levelMaxDimension)) {
+            TraceLog(LOG_WARNING, "LEVEL: [%s] Line %d: grid rows must all be %d cells wide (at most %d rows and columns)",
+                     textPath, lineNumber, columns, levelMaxDimension);
+            valid = false;
+            break;
+        }
+
+        size_t needed = (size_t)(rows + 1) * columns;
+        if (needed > capacity) {
+            capacity = (capacity > 0) ? capacity * 2 : (size_t)columns * 64;
+            health = GAME_REALLOC(health, capacity);
+            types = GAME_REALLOC(types, capacity);
+        }
+
+        for (int j = 0; (j < columns) && valid; j++) {
+            size_t cell = (size_t)rows * columns + j;
+            valid = ParseCell(line[j], &health[cell], &types[cell]);
+            if (!valid) TraceLog(LOG_WARNING, "LEVEL: [%s] Line %d: unknown cell '%c'", textPath, lineNumber, line[j]);
+        }
+        rows++;
+    }
+    fclose(file);
+
+    if (valid && (rows == 0)) {
+        TraceLog(LOG_WARNING, "LEVEL: [%s] No grid rows", textPath);
+        valid = false;
+    }
+    unsigned char *data = valid ? PackLevel(rows, columns, cellWidth, cellHeight, health, types, size) : NULL;
+
+    GAME_FREE(health);
+    GAME_FREE(types);
+    return data;
+}
+
+bool ConvertLevelText(const char *textPath, const char *levelPath) {
+    size_t size = 0;
+    unsigned char *data = PackLevelText(textPath, &size);
+    bool written = (data != NULL) && WriteLevelData(levelPath, data, size);
+    GAME_FREE(data);
+    return written;
+}
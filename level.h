@@ -0,0 +1,50 @@
+#ifndef LEVEL_H
+#define LEVEL_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Binary level files (.lvl): a fixed header followed by one health byte and one type byte per
+// cell, row major. Everything is little endian and read in place from a read-only mapping, so
+// opening a level costs the same for 5x10 and 1000x1000 and pages are only touched when used.
+// Build them from the text format with level_convert (see levels/classic.txt for the syntax).
+
+#define levelMagic 0x564c4b42u      // "BKLV"
+#define levelFormatVersion 1
+#define levelMaxDimension 4096
+
+typedef enum BlockType {
+    BLOCK_EMPTY,
+    BLOCK_NORMAL,
+    BLOCK_FLASHING          // Drops the extra life power-up, at most one is used per level
+} BlockType;
+
+typedef struct {
+    unsigned int magic;
+    unsigned int version;
+    int rows;
+    int columns;
+    float cellWidth;        // Block size in pixels, 0 keeps the game's default size
+    float cellHeight;
+    unsigned int healthOffset;  // From the start of the file, rows * columns bytes each
+    unsigned int typeOffset;
+} LevelHeader;
+
+typedef struct {
+    const LevelHeader *header;
+    const unsigned char *health;    // 0 for empty cells
+    const unsigned char *types;     // BlockType per cell
+    const void *data;               // Mapping, buffer where mmap is unavailable, or caller memory
+    size_t dataSize;
+    bool mapped;                    // Released by UnloadLevelFile, false for LoadLevelFromMemory
+} Level;
+
+bool LoadLevelFile(Level *level, const char *path);     // Validates the header and array bounds, nothing is copied
+bool LoadLevelFromMemory(Level *level, const void *data, size_t size); // .lvl bytes used in place (embedded levels), must be 4 byte aligned
+void UnloadLevelFile(Level *level);
+bool SaveLevelFile(const char *path, int rows, int columns, float cellWidth, float cellHeight,
+                   const unsigned char *health, const unsigned char *types);
+unsigned char *PackLevelText(const char *textPath, size_t *size);   // Text source to .lvl bytes, release with GAME_FREE
+bool ConvertLevelText(const char *textPath, const char *levelPath);  // Text source to .lvl file
+
+#endif
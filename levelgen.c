@@ -0,0 +1,103 @@
+#include "levelgen.h"
+#include "level.h"
+#include "external/stb_perlin.h"    // Implementation is compiled into raylib (SUPPORT_IMAGE_GENERATION)
+
+#include <stddef.h>
+
+#define fnvOffsetBasis 14695981039346656037ull
+#define fnvPrime 1099511628211ull
+#define noiseOctaves 3
+#define noiseWeight 0.75f           // The rest of a cell's fill value is per-cell jitter
+#define noiseContrast 1.2f          // fbm output rarely leaves [-0.4, 0.4], this spreads it over roughly [0, 1]
+
+// Integer hash of the seed and a cell, so any cell can be generated on its own
+static float CellRandom(unsigned int seed, int row, int column, unsigned int salt) {
+    unsigned int hash = (seed * 0x9e3779b9u) ^ ((unsigned int)row * 0x85ebca6bu) ^ ((unsigned int)column * 0xc2b2ae35u) ^ (salt * 0x27d4eb2fu);
+    hash ^= hash >> 16;
+    hash *= 0x7feb352du;
+    hash ^= hash >> 15;
+    hash *= 0x846ca68bu;
+    hash ^= hash >> 16;
+    return (hash >> 8) * (1.0f / 16777216.0f);
+}
+
+LevelGenParams GetDefaultLevelGenParams(unsigned int seed, int rows, int columns) {
+    return (LevelGenParams){
+        .seed = seed,
+        .rows = rows,
+        .columns = columns,
+        .symmetry = (LevelSymmetry)(seed % 3),
+        .density = 0.45f + 0.4f * CellRandom(seed, -1, -1, 0),
+        .noiseScale = 0.08f + 0.15f * CellRandom(seed, -1, -1, 1),
+        .healthWeights = { 6.0f, 3.0f, 1.0f },
+        .flashingBlock = true
+    };
+}
+
+void GenerateLevelCell(const LevelGenParams *params, int row, int column, unsigned char *health, unsigned char *type) {
+    if (params->flashingBlock && (row == 0) && (column == params->columns / 2)) {
+        *health = 1;
+        *type = BLOCK_FLASHING;
+        return;
+    }
+
+    // Mirrored cells read their source cell's noise and jitter
+    if (params->symmetry != SYMMETRY_NONE) {
+        int mirrored = params->columns - 1 - column;
+        if (mirrored < column) column = mirrored;
+    }
+    if (params->symmetry == SYMMETRY_QUAD) {
+        int mirrored = params->rows - 1 - row;
+        if (mirrored < row) row = mirrored;
+    }
+
+    // The seed moves the sample plane through the noise volume; stb_perlin only uses 8 seed bits itself
+    float z = (float)(params->seed & 0xffff) * 0.618f + 0.5f;
+    float noise = stb_perlin_fbm_noise3(column * params->noiseScale, row * params->noiseScale, z, 2.0f, 0.5f, noiseOctaves);
+    float fill = noiseWeight * (0.5f + noiseContrast * noise) + (1.0f - noiseWeight) * CellRandom(params->seed, row, column, 2);
+    if (fill >= params->density) {
+        *health = 0;
+        *type = BLOCK_EMPTY;
+        return;
+    }
+
+    const float *weights = params->healthWeights;
+    float pick = CellRandom(params->seed, row, column, 3) * (weights[0] + weights[1] + weights[2]);
+    *health = (pick < weights[0]) ? 1 : (pick < weights[0] + weights[1]) ? 2 : 3;
+    *type = BLOCK_NORMAL;
+}
+
+void GenerateLevelRows(const LevelGenParams *params, int firstRow, int lastRow, unsigned char *health, unsigned char *types) {
+    for (int i = firstRow; i <= lastRow; i++) {
+        for (int j = 0; j < params->columns; j++) {
+            int cell = i * params->columns + j;
+            GenerateLevelCell(params, i, j, &health[cell], &types[cell]);
+        }
+    }
+}
+
+static unsigned long long HashBytes(unsigned long long hash, const void *data, size_t size) {
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * fnvPrime;
+    return hash;
+}
+
+#define HASH_FIELD(hash, field) hash = HashBytes(hash, &(field), sizeof(field))
+
+// Field by field, so struct padding never reaches the hash
+unsigned long long GetLevelGenHash(const LevelGenParams *params) {
+    unsigned long long hash = fnvOffsetBasis;
+    int version = levelGenVersion;
+    int symmetry = params->symmetry;
+
+    HASH_FIELD(hash, version);
+    HASH_FIELD(hash, params->seed);
+    HASH_FIELD(hash, params->rows);
+    HASH_FIELD(hash, params->columns);
+    HASH_FIELD(hash, symmetry);
+    HASH_FIELD(hash, params->density);
+    HASH_FIELD(hash, params->noiseScale);
+    HASH_FIELD(hash, params->healthWeights);
+    HASH_FIELD(hash, params->flashingBlock);
+    return hash;
+}
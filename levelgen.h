@@ -0,0 +1,34 @@
+#ifndef LEVELGEN_H
+#define LEVELGEN_H
+
+#include <stdbool.h>
+
+// Seeded procedural levels. Every cell is a pure function of the parameters and its position,
+// so a level can be written straight into block storage, split across threads or skipped
+// entirely when GetLevelGenHash() finds it in a cache.
+
+#define levelGenVersion 1       // Bump whenever the output for the same parameters changes, it invalidates caches
+
+typedef enum LevelSymmetry {
+    SYMMETRY_NONE,
+    SYMMETRY_MIRROR,            // Left half mirrored to the right
+    SYMMETRY_QUAD               // Top left quarter mirrored both ways
+} LevelSymmetry;
+
+typedef struct {
+    unsigned int seed;
+    int rows;
+    int columns;
+    LevelSymmetry symmetry;
+    float density;              // Share of cells that get a block, shaped by the noise
+    float noiseScale;           // Noise features per cell, smaller gives bigger clusters
+    float healthWeights[3];     // Relative odds of health 1, 2 and 3
+    bool flashingBlock;         // Top center cell becomes the flashing block
+} LevelGenParams;
+
+LevelGenParams GetDefaultLevelGenParams(unsigned int seed, int rows, int columns);  // Seed picks the symmetry and density too
+void GenerateLevelCell(const LevelGenParams *params, int row, int column, unsigned char *health, unsigned char *type);
+void GenerateLevelRows(const LevelGenParams *params, int firstRow, int lastRow, unsigned char *health, unsigned char *types); // Row major, full grid arrays
+unsigned long long GetLevelGenHash(const LevelGenParams *params);  // Identifies the generated content, for cache file names
+
+#endif
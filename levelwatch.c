@@ -0,0 +1,190 @@
+#include "levelwatch.h"
+#include "allocator.h"
+#include "game.h"
+#include "raylib.h"
+#include "timing.h"
+#include "trace.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#define watchPathMax 1024
+
+// A parsed level together with the buffer it points into
+typedef struct {
+    Level level;
+    unsigned char *data;
+} LoadedLevel;
+
+static LoadedLevel *ReadLevel(const char *path) {
+    size_t size = 0;
+    unsigned char *data = NULL;
+    const char *extension = strrchr(path, '.');
+    if ((extension != NULL) && (strcmp(extension, ".txt") == 0)) data = PackLevelText(path, &size);
+    else {
+        FILE *file = fopen(path, "rb");
+        if (file == NULL) return NULL;
+        fseek(file, 0, SEEK_END);
+        long length = ftell(file);
+        fseek(file, 0, SEEK_SET);
+        if (length > 0) {
+            size = (size_t)length;
+            data = GAME_MALLOC(size);
+            if ((data != NULL) && (fread(data, 1, size, file) != size)) {
+                GAME_FREE(data);
+                data = NULL;
+            }
+        }
+        fclose(file);
+    }
+    if (data == NULL) return NULL;
+
+    // Checked here, so swapping it in on the main thread cannot fail
+    LoadedLevel *loaded = GAME_MALLOC(sizeof(LoadedLevel));
+    bool valid = LoadLevelFromMemory(&loaded->level, data, size);
+    if (valid && ((loaded->level.header->rows > maxGridDimension) || (loaded->level.header->columns > maxGridDimension))) {
+        TraceLog(LOG_WARNING, "LEVEL: [%s] Level is %dx%d, grids are limited to %dx%d", path,
+                 loaded->level.header->rows, loaded->level.header->columns, maxGridDimension, maxGridDimension);
+        valid = false;
+    }
+    if (!valid) {
+        GAME_FREE(loaded);
+        GAME_FREE(data);
+        return NULL;
+    }
+    loaded->data = data;
+    return loaded;
+}
+
+static void FreeLoadedLevel(LoadedLevel *loaded) {
+    if (loaded == NULL) return;
+    GAME_FREE(loaded->data);
+    GAME_FREE(loaded);
+}
+
+static struct {
+    bool running;
+    int notify;
+    int wake[2];                // Written by StopLevelWatch to end the poll
+    pthread_t thread;
+    char path[watchPathMax];
+    const char *fileName;       // Inside path
+    LoadedLevel *pending;       // Exchanged atomically between the threads
+    LoadedLevel *current;       // Main thread only, the level handed out last
+} watch = { 0 };
+
+static void PublishLevel(LoadedLevel *loaded) {
+    FreeLoadedLevel(__atomic_exchange_n(&watch.pending, loaded, __ATOMIC_ACQ_REL));    // Never taken, already outdated
+}
+
+static void ReloadLevel(void) {
+    double start = GetMonotonicTime();
+    LoadedLevel *loaded = ReadLevel(watch.path);
+    double end = GetMonotonicTime();
+    TraceComplete("level reload", start, end);
+
+    if (loaded == NULL) {
+        TraceLog(LOG_WARNING, "LEVEL: [%s] Reload failed, keeping the previous version", watch.path);
+        return;
+    }
+    TraceLog(LOG_INFO, "LEVEL: [%s] Reloaded %dx%d in %.2f ms", watch.path,
+             loaded->level.header->rows, loaded->level.header->columns, (end - start) * 1000.0);
+    PublishLevel(loaded);
+}
+
+static void *WatchThread(void *arg) {
+    (void)arg;
+    TraceSetThreadName("level watch");
+
+    struct pollfd fds[2] = { { .fd = watch.notify, .events = POLLIN }, { .fd = watch.wake[0], .events = POLLIN } };
+    _Alignas(struct inotify_event) char events[4096];
+
+    while (true) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (fds[1].revents & POLLIN) break;
+        if (!(fds[0].revents & POLLIN)) continue;
+
+        // Editors save with several events (or write a temporary and rename it), one parse per batch is enough
+        ssize_t length = read(watch.notify, events, sizeof(events));
+        bool changed = false;
+        for (ssize_t offset = 0; offset < length; ) {
+            const struct inotify_event *event = (const struct inotify_event *)(events + offset);
+            if ((event->len > 0) && (strcmp(event->name, watch.fileName) == 0)) changed = true;
+            offset += sizeof(struct inotify_event) + event->len;
+        }
+        if (changed) ReloadLevel();
+    }
+    return NULL;
+}
+
+bool StartLevelWatch(const char *path) {
+    if (watch.running) StopLevelWatch();
+    if (strlen(path) >= watchPathMax) return false;
+    strcpy(watch.path, path);
+
+    LoadedLevel *loaded = ReadLevel(path);
+    if (loaded == NULL) TraceLog(LOG_WARNING, "LEVEL: [%s] Failed to load level, watching for it to appear", path);
+    PublishLevel(loaded);
+
+    // The directory is watched rather than the file, so files replaced by a rename are still seen
+    char directory[watchPathMax];
+    strcpy(directory, GetDirectoryPath(path));
+    watch.fileName = GetFileName(watch.path);
+
+    watch.notify = inotify_init1(IN_CLOEXEC);
+    if ((watch.notify < 0) || (inotify_add_watch(watch.notify, directory, IN_CLOSE_WRITE | IN_MOVED_TO) < 0) || (pipe(watch.wake) != 0)) {
+        TraceLog(LOG_WARNING, "LEVEL: [%s] Failed to watch directory, hot reload is off", directory);
+        if (watch.notify >= 0) close(watch.notify);
+        return (loaded != NULL);
+    }
+
+    pthread_create(&watch.thread, NULL, WatchThread, NULL);
+    watch.running = true;
+    TraceLog(LOG_INFO, "LEVEL: [%s] Watching for changes", path);
+    return true;
+}
+
+void StopLevelWatch(void) {
+    if (watch.running) {
+        (void)!write(watch.wake[1], "", 1);
+        pthread_join(watch.thread, NULL);
+        close(watch.notify);
+        close(watch.wake[0]);
+        close(watch.wake[1]);
+        watch.running = false;
+    }
+    PublishLevel(NULL);
+    FreeLoadedLevel(watch.current);
+    watch.current = NULL;
+}
+
+const Level *TakeReloadedLevel(void) {
+    LoadedLevel *loaded = __atomic_exchange_n(&watch.pending, NULL, __ATOMIC_ACQ_REL);
+    if (loaded == NULL) return NULL;
+
+    FreeLoadedLevel(watch.current);
+    watch.current = loaded;
+    return &loaded->level;
+}
+#else
+bool StartLevelWatch(const char *path) {
+    TraceLog(LOG_WARNING, "LEVEL: [%s] Hot reload needs inotify, it is only available on Linux", path);
+    return false;
+}
+
+void StopLevelWatch(void) { }
+
+const Level *TakeReloadedLevel(void) {
+    return NULL;
+}
+#endif
@@ -0,0 +1,16 @@
+#ifndef LEVELWATCH_H
+#define LEVELWATCH_H
+
+#include <stdbool.h>
+#include "level.h"
+
+// Hot reload for level design: a background thread watches the level's directory with inotify and
+// parses the file again whenever it is rewritten or replaced, so the main thread only swaps pointers.
+// Files are read into memory instead of mapped, rewriting a mapped file in place would fault the game.
+// Both .lvl files and text sources (.txt, converted on the fly) can be watched. Linux only.
+
+bool StartLevelWatch(const char *path);     // Parses the level once right away, then watches it; false if neither works
+void StopLevelWatch(void);                  // Joins the watcher and releases every level it parsed
+const Level *TakeReloadedLevel(void);       // Newest parse since the last call or NULL; releases the one taken before, so pass it to SetGameLevel right away
+
+#endif
@@ -1,296 +1,603 @@
 ﻿#include <math.h>
 #include <stdio.h>
 #include "raylib.h"
+#include "game.h"
+#include "particles.h"
+#include "capture.h"
+#include "resolution.h"
+#include "hud.h"
+#include "stats.h"
+#include "profiler.h"
+#include "trace.h"
+#include "counters.h"
+#include "replay.h"
+#include "blackbox.h"
+#include "allocator.h"
+#include "embedded_levels.h"
+#include "levelwatch.h"
+#include "assetpack.h"
+#include "startup.h"
 #include <stdlib.h>
 #include <time.h>
 
-typedef enum GameScreen { MENU, GAME, WIN, GAME_OVER } GameScreen;
-
-#define screenWidth 800
-#define screenHeight 480
-#define blocksPerRow 10
-#define blockRowCount 5
-#define blockWidth (screenWidth / blocksPerRow - 20)
-#define blockHeight 20
-#define ballRadius 10
+#define latencySampleCount 600
+#define targetFPS 60
+#define staticScreenMaxLines 2
+#define minCameraZoom 0.25f
+#define assetUploadBudget 0.002  // Seconds of GPU uploads per frame while the asset pack streams in
+#define defaultAssetPack "assets.pak"
 
 typedef struct {
-    Rectangle rect;
-    bool visible;
-    int health;
-} Block;
+    double samples[latencySampleCount];
+    int count;
+    int next;
+} LatencyStats;
 
 typedef struct {
-    Vector2 position;
-    float speedX, speedY;
-    bool active;
-} Ball;
+    const char *text;
+    int x, y;
+    Color color;
+} ScreenLine;
 
 typedef struct {
-    Vector2 position;
-    bool active;
-} PowerUp;
+    const char *name;
+    ScreenLine lines[staticScreenMaxLines];
+    int lineCount;
+} StaticScreen;
 
 typedef struct {
-    Rectangle paddle;
-    int lives;
-    Ball mainBall;
-    Block blocks[blockRowCount][blocksPerRow];
-    Block flashingBlock;
-    bool flashingBlockVisible;
-    PowerUp powerUp;
-    float resetTimer;
-    bool isResetting;
-    float ballStartDelay;
-    bool ballDelayed;
-} GameState;
-
-GameState gameState;
-GameScreen currentScreen = MENU;
-
-void InitGameState() {
-    gameState.lives = 1;
-    gameState.paddle = (Rectangle){ screenWidth / 2 - 50, screenHeight - 50, 100, 20 };
-
-    gameState.mainBall.position = (Vector2){ gameState.paddle.x + gameState.paddle.width / 2, gameState.paddle.y - ballRadius * 2 };
-    gameState.mainBall.speedX = 0;
-    gameState.mainBall.speedY = 0;
-    gameState.mainBall.active = false;
-
-    gameState.ballStartDelay = 1.0f;
-    gameState.ballDelayed = true;
-
-    gameState.resetTimer = 0;
-    gameState.isResetting = false;
-
-    srand(time(NULL));
-
-    // Initialize all blocks
-    for (int i = 0; i < blockRowCount; i++) {
-        for (int j = 0; j < blocksPerRow; j++) {
-            gameState.blocks[i][j].rect.x = j * (blockWidth + 20) + 10;
-            gameState.blocks[i][j].rect.y = i * (blockHeight + 10) + 40;
-            gameState.blocks[i][j].rect.width = blockWidth;
-            gameState.blocks[i][j].rect.height = blockHeight;
-            gameState.blocks[i][j].visible = true;
-            gameState.blocks[i][j].health = 1;
-        }
-    }
+    int redrawFrames;   // Frames still to draw before the screen is considered presented (one per swap buffer)
+    double enterTime;
+    clock_t enterClock;
+    int redraws;
+    int wakeups;
+} IdleStats;
+
+// MENU, WIN and GAME_OVER never change while shown, so they are laid out once and only drawn again
+// when entered or resized; in between, the loop blocks on input with event waiting enabled
+StaticScreen staticScreens[4] = { 0 };
+IdleStats idleStats = { 0 };
+
+// Low latency mode re-polls input right before the frame is submitted and moves the paddle there,
+// instead of using the input polled at the end of the previous EndDrawing. Only the drawn paddle is
+// fresher: UpdateGame has already run the ball and power-up collisions against the paddle moved late
+// in the previous frame, the same input age as default mode gives the physics
+bool lowLatencyMode = false;
+double inputPollTime = 0;
+LatencyStats inputLatency = { 0 };
+
+// Function keys checked at the top of the frame. A press edge that lands in the mid-frame poll is
+// gone by the next frame, so it is latched there and consumed by IsHotkeyPressed
+const int hotkeys[] = { KEY_F3, KEY_F4, KEY_F9, KEY_F10, KEY_F11 };
+unsigned int latchedHotkeys = 0;
+
+double frameStartTime = 0;
+double frameEndTime = 0;    // After the frame limiter wait of the last drawn frame
+float gameBusyTime = 0;     // CPU time of the last GAME frame up to the swap
+bool showResolutionOverlay = false;
+bool showProfilerOverlay = false;
+const char *tracePath = NULL;
+const char *countersPath = NULL;
+bool hwCounters = false;
+const char *replayPath = NULL;
+InputReplay replay = { 0 };
+Level level = { 0 };        // --level, embedded or a mapped file; the built-in layout is used while none is loaded
+const char *levelPath = NULL;   // --level argument, input sessions record it to load the same level again
+const char *assetPackPath = NULL;   // --assets, or assets.pak when there is one
+bool fastStart = false;             // --fast-start: the asset pack and audio device come up after the first MENU frame
+bool startupReported = false;
+bool designMode = false;    // --design: a reloaded level replaces the one being played at once, not at the next restart
+
+// Values bound to HUD fields that are not stored as ints in the game state
+int hudSeconds = 0;
+int hudFPS = 0;
+int fpsField = -1;
+
+void RecordInputLatency(double pollTime) {
+    inputLatency.samples[inputLatency.next] = GetTime() - pollTime;
+    inputLatency.next = (inputLatency.next + 1) % latencySampleCount;
+    if (inputLatency.count < latencySampleCount) inputLatency.count++;
+}
 
-    for (int k = 0; k < 5; k++) {
-        int i = rand() % blockRowCount;
-        int j = rand() % blocksPerRow;
-        if ((i != blockRowCount / 2) || (j != blocksPerRow / 2)) { // Ensure it doesn't replace the flashing block
-            gameState.blocks[i][j].health = (rand() % 2) + 2;  // Randomly assign 2 or 3 health
-        }
-    }
+void ReportInputLatency() {
+    if (inputLatency.count == 0) return;
 
-    gameState.flashingBlock.rect.x = (blocksPerRow / 2) * (blockWidth + 20) + 10;
-    gameState.flashingBlock.rect.y = 40;
-    gameState.flashingBlock.rect.width = blockWidth;
-    gameState.flashingBlock.rect.height = blockHeight;
-    gameState.flashingBlock.visible = true;
-    gameState.flashingBlock.health = 1;
+    double sorted[latencySampleCount];
+    for (int i = 0; i < inputLatency.count; i++) sorted[i] = inputLatency.samples[i] * 1000.0;
+    SampleStats stats = ComputeSampleStats(sorted, inputLatency.count);
 
-    gameState.powerUp.position = (Vector2){0, 0};
-    gameState.powerUp.active = false;
+    TraceLog(LOG_INFO, "LATENCY: input poll to swap (%s, %d frames): p50 %.3f ms, p95 %.3f ms, p99 %.3f ms, max %.3f ms",
+             lowLatencyMode ? "low latency" : "default", stats.count, stats.median, stats.p95, stats.p99, stats.max);
 }
 
+GameInput ReadGameInput() {
+    return (GameInput){ IsKeyDown(KEY_LEFT), IsKeyDown(KEY_RIGHT) };
+}
 
-void ResetBall() {
-    gameState.mainBall.position = (Vector2){ gameState.paddle.x + gameState.paddle.width / 2, gameState.paddle.y - ballRadius * 2 };
-    gameState.mainBall.speedX = 0;
-    gameState.mainBall.speedY = 0;
-    gameState.isResetting = false;
-    //wait
-    gameState.ballStartDelay = 1.0f;
-    gameState.ballDelayed = true;
+void LatchHotkeyPresses() {
+    for (int i = 0; i < (int)(sizeof(hotkeys) / sizeof(hotkeys[0])); i++) {
+        if (IsKeyPressed(hotkeys[i])) latchedHotkeys |= 1u << i;
+    }
 }
 
+// raylib's frame limiter waits between the swap and its input poll, which leaves no point to take
+// the swap time at. It is off (SetTargetFPS(0)), so EndDrawing swaps and polls at once and frames
+// wait here instead; GetFrameTime() still spans swap to swap, raylib counts the wait as part of the
+// next frame's update time. Returns whether it waited
+bool WaitForFrameSlot() {
+    double remaining = 1.0 / targetFPS - (GetTime() - frameEndTime);
+    if (remaining > 0.0) WaitTime(remaining);
+    frameEndTime = GetTime();
+    return (remaining > 0.0);
+}
+
+bool IsHotkeyPressed(int key) {
+    for (int i = 0; i < (int)(sizeof(hotkeys) / sizeof(hotkeys[0])); i++) {
+        if (hotkeys[i] != key) continue;
+        bool latched = (latchedHotkeys & (1u << i)) != 0;
+        latchedHotkeys &= ~(1u << i);
+        return latched || IsKeyPressed(key);
+    }
+    return IsKeyPressed(key);
+}
 
+void InitHudFields() {
+    AddHudField("Lives", &gameState.lives, HUD_NUMBER, (Vector2){ 10, screenHeight - 25 }, 20, WHITE, false);
+    AddHudField("Blocks", &gameState.blocksRemaining, HUD_NUMBER, (Vector2){ screenWidth / 2 - 50, screenHeight - 25 }, 20, WHITE, false);
+    AddHudField("Time", &hudSeconds, HUD_CLOCK, (Vector2){ screenWidth - 10, screenHeight - 25 }, 20, WHITE, true);
+    fpsField = AddHudField("FPS", &hudFPS, HUD_NUMBER, (Vector2){ 10, 10 }, 10, LIME, false);
+    SetHudFieldVisible(fpsField, false);
+}
+
+// Fields larger than the screen are zoomed out to fit their width (down to minCameraZoom) and
+// scrolled to follow the ball; a screen sized field gets the identity camera
+Camera2D GetFieldCamera() {
+    const LevelLayout *layout = &gameState.layout;
+    float zoom = fmaxf(fminf(1.0f, screenWidth / layout->width), minCameraZoom);
+    Vector2 half = { screenWidth / 2 / zoom, screenHeight / 2 / zoom };
+    Vector2 target = gameState.mainBall.position;
+    target.x = fminf(fmaxf(target.x, half.x), fmaxf(layout->width - half.x, half.x));
+    target.y = fminf(fmaxf(target.y, half.y), fmaxf(layout->height - half.y, half.y));
+    return (Camera2D){ .offset = { screenWidth / 2, screenHeight / 2 }, .target = target, .rotation = 0.0f, .zoom = zoom };
+}
 
-bool AreAllBlocksDestroyed() {
-    for (int i = 0; i < blockRowCount; i++) {
-        for (int j = 0; j < blocksPerRow; j++) {
-            if (gameState.blocks[i][j].visible) {
-                return false;
+void DrawGame() {
+    hudSeconds = (int)gameState.elapsedTime;
+    hudFPS = GetFPS();
+    SetHudFieldVisible(fpsField, showResolutionOverlay);
+    PROFILE_BEGIN(ZONE_DRAW);
+    UpdateHud();
+
+    Camera2D camera = GetFieldCamera();
+    BeginSceneRender(camera);
+
+    // Only the cells under the camera are visited, whatever the grid size
+    Vector2 viewOrigin = GetScreenToWorld2D((Vector2){ 0, 0 }, camera);
+    BlockRange range = GetBlockRange((Rectangle){ viewOrigin.x, viewOrigin.y, screenWidth / camera.zoom, screenHeight / camera.zoom });
+    for (int i = range.firstRow; i <= range.lastRow; i++) {
+        for (int j = range.firstColumn; j <= range.lastColumn; j++) {
+            const Block *block = GetBlock(i, j);
+            if (block->visible) {
+                DrawRectangleRec(GetBlockRect(i, j), GetBlockColor(block->health));
             }
         }
     }
-    return true;
-}
 
-void UpdateGame(float deltaTime) {
-    if (gameState.isResetting) {
-        gameState.resetTimer -= deltaTime;
-        if (gameState.resetTimer <= 0) {
-            ResetBall();
-        }
+    if (gameState.flashingBlock.visible) {
+        Color flashingColor = (fmod(GetTime() * 10, 2) < 1) ? GREEN : RED;
+        DrawRectangleRec(gameState.flashingBlock.rect, flashingColor);
     }
 
-    if (gameState.ballDelayed) {
-        gameState.ballStartDelay -= deltaTime;
-        if (gameState.ballStartDelay <= 0) {
-            gameState.mainBall.speedX = (rand() % 201) - 100;
-            gameState.mainBall.speedY = -500;
-            gameState.mainBall.active = true;
-            gameState.ballDelayed = false;
-        }
+    DrawParticles();
+
+    if (gameState.powerUp.active) {
+        DrawRectangle(gameState.powerUp.position.x - 5, gameState.powerUp.position.y - 5, 10, 10, GREEN);
     }
 
-    if (IsKeyDown(KEY_LEFT)) gameState.paddle.x -= 400 * deltaTime;
-    if (IsKeyDown(KEY_RIGHT)) gameState.paddle.x += 400 * deltaTime;
-    if (gameState.paddle.x < 0) gameState.paddle.x = 0;
-    if (gameState.paddle.x + gameState.paddle.width > screenWidth) gameState.paddle.x = screenWidth - gameState.paddle.width;
+    // Everything above is independent of the paddle, so sample input as late as possible here
+    if (lowLatencyMode) {
+        PROFILE_END(ZONE_DRAW);
+        PROFILE_BEGIN(ZONE_INPUT);
+        PollInputEvents();
+        LatchHotkeyPresses();
+        inputPollTime = GetTime();
+        GameInput lateInput = ReadGameInput();
+        UpdatePaddle(GetFrameTime(), lateInput);
+        BlackBoxRecordLateInput(GetFrameTime(), lateInput);
+        PROFILE_END(ZONE_INPUT);
+        PROFILE_BEGIN(ZONE_DRAW);
+    }
 
-    if (!gameState.isResetting && !gameState.ballDelayed) {
-        gameState.mainBall.position.x += gameState.mainBall.speedX * deltaTime;
-        gameState.mainBall.position.y += gameState.mainBall.speedY * deltaTime;
+    DrawRectangleRec(gameState.paddle, WHITE);
+    DrawCircleV(gameState.mainBall.position, ballRadius, WHITE);
+    EndSceneRender();
 
-        if (gameState.mainBall.position.x < ballRadius || gameState.mainBall.position.x > screenWidth - ballRadius) {
-            gameState.mainBall.speedX *= -1;
-        }
+    // The HUD stays at native resolution on top of the upscaled scene
+    BeginDrawing();
+    ClearBackground(BLACK);
+    DrawSceneToScreen();
+    DrawHud();
+    if (showResolutionOverlay) DrawResolutionOverlay(screenWidth - 260, 10);
+#if PROFILER_ENABLED
+    if (showProfilerOverlay) DrawProfilerOverlay(10, 30);
+#endif
+
+    gameBusyTime = (float)(GetTime() - frameStartTime);
+    CaptureFrame();
+    PROFILE_END(ZONE_DRAW);
+
+    PROFILE_BEGIN(ZONE_SWAP);
+    COUNT_BATCH();
+    EndDrawing();
+    RecordInputLatency(inputPollTime);      // Includes the input poll right after the swap, no limiter wait
 
-        if (gameState.mainBall.position.y < ballRadius) {
-            gameState.mainBall.speedY *= -1;
-        }
+    // Poll again after the wait, the same swap, wait, poll order as raylib's limiter. That poll drops
+    // the press edges of the one in EndDrawing, GAME frames only check the hotkeys for those
+    LatchHotkeyPresses();
+    if (WaitForFrameSlot()) PollInputEvents();
+    PROFILE_END(ZONE_SWAP);
+}
 
-        if (gameState.mainBall.position.y >= screenHeight - 30 && !gameState.isResetting) {
-            gameState.lives--;
-            if (gameState.lives > 0) {
-                ResetBall();
-            } else {
-                currentScreen = GAME_OVER;
-            }
-        }
+void AddScreenLine(StaticScreen *screen, const char *text, int y, Color color) {
+    ScreenLine *line = &screen->lines[screen->lineCount++];
+    line->text = text;
+    line->x = screenWidth / 2 - MeasureText(text, 20) / 2;
+    line->y = y;
+    line->color = color;
+}
 
-        if (CheckCollisionCircleRec(gameState.mainBall.position, ballRadius, gameState.paddle)) {
-            gameState.mainBall.speedY = -fabsf(gameState.mainBall.speedY);
-            gameState.mainBall.speedX = (gameState.mainBall.position.x - (gameState.paddle.x + gameState.paddle.width / 2)) / (gameState.paddle.width / 2) * 250;
-        }
+void InitStaticScreens() {
+    staticScreens[MENU].name = "MENU";
+    AddScreenLine(&staticScreens[MENU], "Press ENTER to Start", screenHeight / 2 - 10, WHITE);
+    AddScreenLine(&staticScreens[MENU], "Press ESC to Exit", screenHeight / 2 + 20, WHITE);
 
-        for (int i = 0; i < blockRowCount; i++) {
-            for (int j = 0; j < blocksPerRow; j++) {
-                if (gameState.blocks[i][j].visible && CheckCollisionCircleRec(gameState.mainBall.position, ballRadius, gameState.blocks[i][j].rect)) {
-                    gameState.blocks[i][j].health--;
-                    if (gameState.blocks[i][j].health <= 0) {
-                        gameState.blocks[i][j].visible = false;
-                    }
-                    gameState.mainBall.speedY *= -1;
-                }
-            }
-        }
+    staticScreens[WIN].name = "WIN";
+    AddScreenLine(&staticScreens[WIN], "You Win! Press R to Restart or ESC to Exit", screenHeight / 2, GREEN);
 
-        if (gameState.flashingBlock.visible && CheckCollisionCircleRec(gameState.mainBall.position, ballRadius, gameState.flashingBlock.rect)) {
-            gameState.flashingBlock.visible = false;
-            gameState.powerUp.position = (Vector2){ gameState.flashingBlock.rect.x + blockWidth / 2, gameState.flashingBlock.rect.y };
-            gameState.powerUp.active = true;
-            gameState.mainBall.speedY *= -1;
-        }
+    staticScreens[GAME_OVER].name = "GAME_OVER";
+    AddScreenLine(&staticScreens[GAME_OVER], "Game Over! Press R to Restart", screenHeight / 2, RED);
+}
 
-        if (gameState.powerUp.active) {
-            gameState.powerUp.position.y += 200 * deltaTime;
-            if (gameState.powerUp.position.y >= screenHeight) {
-                gameState.powerUp.active = false;
-            }
-        }
+void EnterStaticScreen() {
+    if (AreAssetsLoaded()) EnableEventWaiting();
+    idleStats.redrawFrames = 2;
+    idleStats.enterTime = GetTime();
+    idleStats.enterClock = clock();
+    idleStats.redraws = 0;
+    idleStats.wakeups = 0;
+}
 
-        // PowerCollect
-        if (gameState.powerUp.active && CheckCollisionCircleRec(gameState.powerUp.position, ballRadius, gameState.paddle)) {
-            gameState.lives++;
-            gameState.powerUp.active = false;
-        }
+void LeaveStaticScreen(GameScreen screen) {
+    DisableEventWaiting();
 
-        if (AreAllBlocksDestroyed()) {
-            currentScreen = WIN;
+    double wallTime = GetTime() - idleStats.enterTime;
+    double cpuTime = (double)(clock() - idleStats.enterClock) / CLOCKS_PER_SEC;
+    TraceLog(LOG_INFO, "IDLE: %s shown %.1f s, %d redraws, %d wakeups, %.2f%% cpu",
+             staticScreens[screen].name, wallTime, idleStats.redraws, idleStats.wakeups,
+             (wallTime > 0) ? cpuTime / wallTime * 100.0 : 0.0);
+}
+
+void UpdateStaticScreen(const StaticScreen *screen) {
+    if (IsWindowResized()) idleStats.redrawFrames = 2;
+
+    if (idleStats.redrawFrames > 0) {
+        WaitForFrameSlot();     // Before drawing, so the poll in EndDrawing stays the latest one
+        BeginDrawing();
+        ClearBackground(BLACK);
+        for (int i = 0; i < screen->lineCount; i++) {
+            DrawText(screen->lines[i].text, screen->lines[i].x, screen->lines[i].y, 20, screen->lines[i].color);
+        }
+        if (!AreAssetsLoaded()) {
+            int loaded, total;
+            GetAssetProgress(&loaded, &total);
+            DrawText(TextFormat("Loading assets %d/%d", loaded, total), 10, screenHeight - 30, 20, GRAY);
         }
+        CaptureFrame();
+        EndDrawing();
+        idleStats.redrawFrames--;
+        idleStats.redraws++;
+    } else {
+        // Nothing changed: skip the frame entirely and sleep until the next input event
+        PollInputEvents();
+        idleStats.wakeups++;
     }
 }
 
-void DrawGame() {
-    BeginDrawing();
-    ClearBackground(BLACK);
+// The pack streams in behind whatever screen is up; static screens keep redrawing the progress
+// and only start sleeping on input once it is done
+void PumpAssets() {
+    if (AreAssetsLoaded()) return;
+    UpdateAssetPack(assetUploadBudget);
+    if (AreAssetsLoaded()) {
+        StartupMark("assets uploaded");
+        if (startupReported) ReportStartupTimeline();
+    }
+    if (currentScreen == GAME) return;
 
-    DrawRectangleRec(gameState.paddle, WHITE);
-    DrawCircleV(gameState.mainBall.position, ballRadius, WHITE);
+    idleStats.redrawFrames = 2;
+    if (AreAssetsLoaded()) EnableEventWaiting();
+    else DisableEventWaiting();     // The pack may have been opened after the screen went to sleep
+}
 
-    for (int i = 0; i < blockRowCount; i++) {
-        for (int j = 0; j < blocksPerRow; j++) {
-            if (gameState.blocks[i][j].visible) {
-                Color blockColor = (gameState.blocks[i][j].health == 1) ? YELLOW : (gameState.blocks[i][j].health == 2) ? RED : BLUE;
-                DrawRectangleRec(gameState.blocks[i][j].rect, blockColor);
-            }
-        }
+void OpenAssets() {
+    if (assetPackPath == NULL) return;
+    OpenAssetPack(assetPackPath);
+    StartupMark("asset pack open");
+}
+
+// Only sounds need the audio device, it stays closed otherwise
+void InitAudio() {
+    if (GetAssetCount(ASSET_SOUND) == 0) return;
+    InitAudioDevice();
+    StartupMark("audio device");
+}
+
+// The first MENU frame is on screen: report how long that took, then bring up what fast start deferred
+void FinishStartup() {
+    StartupMark("first MENU frame");
+    ReportStartupTimeline();
+    if (fastStart) {
+        OpenAssets();
+        InitAudio();
+        ReportStartupTimeline();
     }
+    startupReported = true;
+}
 
-    if (gameState.flashingBlock.visible) {
-        Color flashingColor = (fmod(GetTime() * 10, 2) < 1) ? GREEN : RED;
-        DrawRectangleRec(gameState.flashingBlock.rect, flashingColor);
+// Levels compiled in from levels/*.txt are picked by name, anything else is treated as a path
+const EmbeddedLevel *FindEmbeddedLevel(const char *name) {
+    for (int i = 0; i < embeddedLevelCount; i++) {
+        if (TextIsEqual(embeddedLevels[i].name, name)) return &embeddedLevels[i];
     }
+    return NULL;
+}
 
-    if (gameState.powerUp.active) {
-        DrawRectangle(gameState.powerUp.position.x - 5, gameState.powerUp.position.y - 5, 10, 10, GREEN);
+// With --watch the level file is parsed again on a background thread whenever it changes; this only swaps it in
+bool ApplyReloadedLevel() {
+    const Level *reloaded = TakeReloadedLevel();
+    if (reloaded != NULL) SetGameLevel(reloaded);
+    return (reloaded != NULL);
+}
+
+void StartGame() {
+    ApplyReloadedLevel();
+    unsigned int seed = (unsigned int)time(NULL);
+    InitGameState(seed);
+    currentScreen = GAME;
+    if (replayPath != NULL) BeginReplayRecording(&replay, seed, levelPath);
+    BlackBoxLevelStart();
+}
+
+void ToggleCapture() {
+    if (IsCapturing()) StopCapture();
+    else StartCapture(TextFormat("capture_%ld.gif", (long)time(NULL)), CAPTURE_GIF, captureDefaultFPS);
+}
+
+void ToggleTrace() {
+    if (!IsTracing()) {
+        StartTrace();
+        TraceLog(LOG_INFO, "TRACE: Recording");
+    } else {
+        StopTrace();
+        FlushTrace(TextFormat("trace_%ld.json", (long)time(NULL)));
     }
+}
 
-    DrawText(TextFormat("Lives: %d", gameState.lives), 10, screenHeight - 25, 20, WHITE);
-    EndDrawing();
+void CloseGame() {
+    if (currentScreen != GAME) LeaveStaticScreen(currentScreen);
+    if (countersPath != NULL) ExportCounters(countersPath);
+    if ((replayPath != NULL) && (currentScreen == GAME) && (replay.tickCount > 0)) SaveReplay(&replay, replayPath);
+    UnloadReplay(&replay);
+    CloseBlackBox();
+    if (IsTracing()) FlushTrace((tracePath != NULL) ? tracePath : TextFormat("trace_%ld.json", (long)time(NULL)));
+    StopCapture();
+    ReportInputLatency();
+    UnloadDynamicResolution();
+    UnloadHud();
+    CloseAssetPack();
+    if (IsAudioDeviceReady()) CloseAudioDevice();
+    UnloadLevel();
+    SetGameLevel(NULL);
+    UnloadLevelFile(&level);
+    StopLevelWatch();
+    UnloadCountedRenderBatch();
+    CloseWindow();
+
+    // After CloseWindow, so whatever is still live here has leaked
+    if (GetAllocatorMode() == ALLOCATOR_TRACKING) ReportAllocations(20);
 }
 
-int main(void) {
+int main(int argc, char *argv[]) {
+    BeginStartupTimeline();
+    const char *recordPath = NULL;
+    int recordFPS = captureDefaultFPS;
+    bool adaptiveResolution = true;
+    float hitchBudget = 0.0f;
+    const char *hitchDirectory = NULL;
+    long generatorSeed = -1;
+    bool watchLevel = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (TextIsEqual(argv[i], "--low-latency")) lowLatencyMode = true;
+        else if (TextIsEqual(argv[i], "--record") && (i + 1 < argc)) recordPath = argv[++i];
+        else if (TextIsEqual(argv[i], "--record-fps") && (i + 1 < argc)) recordFPS = atoi(argv[++i]);
+        else if (TextIsEqual(argv[i], "--fixed-resolution")) adaptiveResolution = false;
+        else if (TextIsEqual(argv[i], "--trace") && (i + 1 < argc)) tracePath = argv[++i];
+        else if (TextIsEqual(argv[i], "--counters") && (i + 1 < argc)) countersPath = argv[++i];
+        else if (TextIsEqual(argv[i], "--hw-counters")) hwCounters = true;
+        else if (TextIsEqual(argv[i], "--record-input") && (i + 1 < argc)) replayPath = argv[++i];
+        else if (TextIsEqual(argv[i], "--hitch-ms") && (i + 1 < argc)) hitchBudget = (float)atof(argv[++i]);
+        else if (TextIsEqual(argv[i], "--hitch-dir") && (i + 1 < argc)) hitchDirectory = argv[++i];
+        else if (TextIsEqual(argv[i], "--track-allocations")) SetAllocatorMode(ALLOCATOR_TRACKING);
+        else if (TextIsEqual(argv[i], "--level") && (i + 1 < argc)) levelPath = argv[++i];
+        else if (TextIsEqual(argv[i], "--procedural") && (i + 1 < argc)) generatorSeed = atol(argv[++i]);
+        else if (TextIsEqual(argv[i], "--watch")) watchLevel = true;
+        else if (TextIsEqual(argv[i], "--assets") && (i + 1 < argc)) assetPackPath = argv[++i];
+        else if (TextIsEqual(argv[i], "--fast-start")) fastStart = true;
+        else if (TextIsEqual(argv[i], "--design")) watchLevel = designMode = true;
+        else if (TextIsEqual(argv[i], "--grid") && (i + 1 < argc)) {
+            int rows = 0, columns = 0;
+            if (sscanf(argv[++i], "%dx%d", &rows, &columns) == 2) SetDefaultLevelSize(rows, columns);
+        }
+    }
+
+    // The late paddle update of low latency mode happens outside UpdateGame and would not replay
+    if ((replayPath != NULL) && lowLatencyMode) {
+        TraceLog(LOG_WARNING, "REPLAY: --low-latency is ignored while recording input");
+        lowLatencyMode = false;
+    }
+
+    if ((levelPath == NULL) && watchLevel) {
+        TraceLog(LOG_WARNING, "LEVEL: %s needs --level <file>, nothing is watched", designMode ? "--design" : "--watch");
+    }
+
+    // Watched levels are always files, .txt sources included, and are never mapped
+    if ((levelPath != NULL) && watchLevel) {
+        if (StartLevelWatch(levelPath)) ApplyReloadedLevel();
+    }
+    else if (levelPath != NULL) {
+        const EmbeddedLevel *embedded = FindEmbeddedLevel(levelPath);
+        bool loaded = (embedded != NULL) ? LoadLevelFromMemory(&level, embedded->data, embedded->size) : LoadLevelFile(&level, levelPath);
+        if (loaded && !SetGameLevel(&level)) UnloadLevelFile(&level);
+    }
+    else if (generatorSeed >= 0) {
+        int rows, columns;
+        GetDefaultLevelSize(&rows, &columns);
+        LevelGenParams params = GetDefaultLevelGenParams((unsigned int)generatorSeed, rows, columns);
+        SetGameLevelGenerator(&params);
+    }
+
+    if ((assetPackPath == NULL) && FileExists(defaultAssetPack)) assetPackPath = defaultAssetPack;
+    StartupMark("arguments and level");
+
+    // Decoding starts before the window exists, only the uploads wait for it
+    if (!fastStart) OpenAssets();
+
     InitWindow(screenWidth, screenHeight, "Block Kuzushi wannabe type game");
-    SetTargetFPS(60);
+    SetTargetFPS(0);        // Frames are paced by WaitForFrameSlot, static screens block on input between them
+    if (COUNTERS_ENABLED) LoadCountedRenderBatch();
+    StartupMark("window, GL context and font");
+    if (!fastStart) InitAudio();
+
+    InitStaticScreens();
+    InitDynamicResolution(screenWidth, screenHeight, 1.0f / targetFPS, adaptiveResolution);
+    InitHudFields();
+    StartupMark("screens, resolution and HUD");
+
+#if PROFILER_ENABLED
+    if (hwCounters) EnableProfilerHwCounters();
+#else
+    if (hwCounters) TraceLog(LOG_WARNING, "PROFILER: --hw-counters is ignored, profiler zones are compiled out (build with ENABLE_PROFILER)");
+#endif
+
+    if (hitchBudget > 0.0f) InitBlackBox(hitchBudget, hitchDirectory);
+
+    TraceSetThreadName("main");
+    if (tracePath != NULL) StartTrace();
+
+    if (recordPath != NULL) StartCapture(recordPath, IsFileExtension(recordPath, ".gif") ? CAPTURE_GIF : CAPTURE_PNG, recordFPS);
+
+    StartupMark("instrumentation");
+
+    GameScreen previousScreen = GAME;
+    int staleFrameTimes = 0;
 
     while (!WindowShouldClose()) {
+        if (currentScreen != previousScreen) {
+            // A level ended: its session is complete
+            if ((previousScreen == GAME) && (replayPath != NULL) && (replay.tickCount > 0)) SaveReplay(&replay, replayPath);
+            if (previousScreen != GAME) {
+                LeaveStaticScreen(previousScreen);
+                // Frame times still span the time spent blocked on the static screen
+                staleFrameTimes = 2;
+            }
+            if (currentScreen != GAME) EnterStaticScreen();
+            previousScreen = currentScreen;
+        }
+        PumpAssets();
+
+        if (IsHotkeyPressed(KEY_F9)) ToggleCapture();
+        if (IsHotkeyPressed(KEY_F3)) showResolutionOverlay = !showResolutionOverlay;
+        if (IsHotkeyPressed(KEY_F4)) showProfilerOverlay = !showProfilerOverlay;
+        if (IsHotkeyPressed(KEY_F10)) ToggleTrace();
+        if (IsHotkeyPressed(KEY_F11)) ExportCounters(TextFormat("counters_%ld.csv", (long)time(NULL)));
+
         float deltaTime = GetFrameTime();
+        bool frameTimeStale = (staleFrameTimes > 0);
+        if (frameTimeStale) {
+            deltaTime = 1.0f / targetFPS;
+            staleFrameTimes--;
+        }
+        // Input was polled at the end of the previous EndDrawing, right before we got here
+        frameStartTime = GetTime();
+        inputPollTime = frameStartTime;
 
         switch (currentScreen) {
             case MENU:
-                BeginDrawing();
-                ClearBackground(BLACK);
-                DrawText("Press ENTER to Start", screenWidth / 2 - MeasureText("Press ENTER to Start", 20) / 2, screenHeight / 2 - 10, 20, WHITE);
-                DrawText("Press ESC to Exit", screenWidth / 2 - MeasureText("Press ESC to Exit", 20) / 2, screenHeight / 2 + 20, 20, WHITE);
-                EndDrawing();
+                UpdateStaticScreen(&staticScreens[MENU]);
 
                 if (IsKeyPressed(KEY_ENTER)) {
-                    InitGameState();
-                    currentScreen = GAME;
+                    StartGame();
                 }
                 break;
 
             case GAME:
-                UpdateGame(deltaTime);
+            {
+                if (designMode && ApplyReloadedLevel()) {
+                    // Keep the session played so far; it names the level file, so it only replays against the version it was played on
+                    if ((replayPath != NULL) && (replay.tickCount > 0)) SaveReplay(&replay, replayPath);
+                    StartGame();
+                }
+
+                // Everything a GAME frame needs is created before the level starts
+                NO_ALLOCATIONS_BEGIN("GAME");
+                if (!frameTimeStale) UpdateResolutionScale(GetFrameTime(), gameBusyTime);
+
+                // In low latency mode the paddle is moved in DrawGame instead
+                PROFILE_BEGIN(ZONE_INPUT);
+                GameInput input = lowLatencyMode ? (GameInput){ 0 } : ReadGameInput();
+                PROFILE_END(ZONE_INPUT);
+
+                if (replayPath != NULL) RecordReplayTick(&replay, deltaTime, input);
+                BlackBoxRecordTick(deltaTime, input);
+
+                PROFILE_BEGIN(ZONE_UPDATE);
+                UpdateGame(deltaTime, input);
+                PROFILE_END(ZONE_UPDATE);
+
                 DrawGame();
-                break;
+
+                COUNTER_SET(COUNTER_BALLS_ACTIVE, !gameState.ballDelayed && !gameState.isResetting);
+                COUNTER_SET(COUNTER_POWERUPS_ACTIVE, gameState.powerUp.active);
+                COUNTERS_FRAME_END();
+                PROFILE_FRAME_END();
+                BlackBoxFrameEnd(frameTimeStale);
+                NO_ALLOCATIONS_END();
+            }   break;
 
             case WIN:
-                BeginDrawing();
-                ClearBackground(BLACK);
-                DrawText("You Win! Press R to Restart or ESC to Exit", screenWidth / 2 - MeasureText("You Win! Press R to Restart or ESC to Exit", 20) / 2, screenHeight / 2, 20, GREEN);
-                EndDrawing();
+                UpdateStaticScreen(&staticScreens[WIN]);
 
                 if (IsKeyPressed(KEY_R)) {
-                    InitGameState();
-                    currentScreen = GAME;
+                    StartGame();
                 } else if (IsKeyPressed(KEY_ESCAPE)) {
-                    CloseWindow();
+                    CloseGame();
                     return 0;
                 }
                 break;
 
             case GAME_OVER:
-                BeginDrawing();
-                ClearBackground(BLACK);
-                DrawText("Game Over! Press R to Restart", screenWidth / 2 - MeasureText("Game Over! Press R to Restart", 20) / 2, screenHeight / 2, 20, RED);
-                EndDrawing();
+                UpdateStaticScreen(&staticScreens[GAME_OVER]);
 
                 if (IsKeyPressed(KEY_R)) {
-                    InitGameState();
-                    currentScreen = GAME;
+                    StartGame();
                 }
                 break;
         }
+
+        if (!startupReported) FinishStartup();
     }
 
-    CloseWindow();
+    CloseGame();
     return 0;
 }
@@ -0,0 +1,110 @@
+#include "particles.h"
+#include "rlgl.h"
+#include <math.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define PARTICLES_SSE
+#endif
+
+static ParticlePool pool = { 0 };
+#define particleInitialSeed 0x9e3779b9u
+
+static unsigned int particleSeed = particleInitialSeed;
+
+// Particles are cosmetic, so they get their own generator and never disturb the game's random sequence
+static float RandomUnit(void) {
+    particleSeed ^= particleSeed << 13;
+    particleSeed ^= particleSeed >> 17;
+    particleSeed ^= particleSeed << 5;
+    return (float)(particleSeed >> 8) / 16777216.0f;
+}
+
+void ClearParticles(void) {
+    pool.count = 0;
+    particleSeed = particleInitialSeed;
+}
+
+unsigned int GetParticleRandomState(void) {
+    return particleSeed;
+}
+
+void SetParticleRandomState(unsigned int state) {
+    particleSeed = state;
+}
+
+void EmitParticles(Vector2 origin, int count, Color color) {
+    if (pool.count + count > particleCapacity) count = particleCapacity - pool.count;
+
+    for (int i = pool.count; i < pool.count + count; i++) {
+        float angle = RandomUnit() * 2.0f * PI;
+        float speed = 60.0f + RandomUnit() * 180.0f;
+        pool.posX[i] = origin.x;
+        pool.posY[i] = origin.y;
+        pool.velX[i] = cosf(angle) * speed;
+        pool.velY[i] = sinf(angle) * speed;
+        pool.life[i] = particleLifetime * (0.5f + RandomUnit() * 0.5f);
+        pool.color[i] = color;
+    }
+    pool.count += count;
+}
+
+void UpdateParticles(float deltaTime) {
+    int i = 0;
+#if defined(PARTICLES_SSE)
+    __m128 dt = _mm_set1_ps(deltaTime);
+    __m128 gravity = _mm_set1_ps(particleGravity * deltaTime);
+    for (; i + 4 <= pool.count; i += 4) {
+        __m128 vx = _mm_loadu_ps(&pool.velX[i]);
+        __m128 vy = _mm_add_ps(_mm_loadu_ps(&pool.velY[i]), gravity);
+        _mm_storeu_ps(&pool.velY[i], vy);
+        _mm_storeu_ps(&pool.posX[i], _mm_add_ps(_mm_loadu_ps(&pool.posX[i]), _mm_mul_ps(vx, dt)));
+        _mm_storeu_ps(&pool.posY[i], _mm_add_ps(_mm_loadu_ps(&pool.posY[i]), _mm_mul_ps(vy, dt)));
+        _mm_storeu_ps(&pool.life[i], _mm_sub_ps(_mm_loadu_ps(&pool.life[i]), dt));
+    }
+#endif
+    for (; i < pool.count; i++) {
+        pool.velY[i] += particleGravity * deltaTime;
+        pool.posX[i] += pool.velX[i] * deltaTime;
+        pool.posY[i] += pool.velY[i] * deltaTime;
+        pool.life[i] -= deltaTime;
+    }
+
+    // Swap-remove expired particles, order does not matter for drawing
+    i = 0;
+    while (i < pool.count) {
+        if (pool.life[i] > 0.0f) {
+            i++;
+            continue;
+        }
+        int last = --pool.count;
+        pool.posX[i] = pool.posX[last];
+        pool.posY[i] = pool.posY[last];
+        pool.velX[i] = pool.velX[last];
+        pool.velY[i] = pool.velY[last];
+        pool.life[i] = pool.life[last];
+        pool.color[i] = pool.color[last];
+    }
+}
+
+void DrawParticles(void) {
+    if (pool.count == 0) return;
+
+    const float half = particleSize / 2.0f;
+
+    // One RL_QUADS stream for the whole pool; rlgl flushes by itself whenever the batch buffer fills up
+    rlBegin(RL_QUADS);
+    for (int i = 0; i < pool.count; i++) {
+        Color color = pool.color[i];
+        rlColor4ub(color.r, color.g, color.b, (unsigned char)(255.0f * pool.life[i] / particleLifetime));
+        rlVertex2f(pool.posX[i] - half, pool.posY[i] - half);
+        rlVertex2f(pool.posX[i] - half, pool.posY[i] + half);
+        rlVertex2f(pool.posX[i] + half, pool.posY[i] + half);
+        rlVertex2f(pool.posX[i] + half, pool.posY[i] - half);
+    }
+    rlEnd();
+}
+
+int GetParticleCount(void) {
+    return pool.count;
+}
@@ -0,0 +1,30 @@
+#ifndef PARTICLES_H
+#define PARTICLES_H
+
+#include "raylib.h"
+
+#define particleCapacity 65536
+#define particleLifetime 0.8f
+#define particleGravity 600.0f
+#define particleSize 3.0f
+
+// Fixed pool, structure of arrays so the integration step runs 4 particles per SSE instruction
+typedef struct {
+    float posX[particleCapacity];
+    float posY[particleCapacity];
+    float velX[particleCapacity];
+    float velY[particleCapacity];
+    float life[particleCapacity];
+    Color color[particleCapacity];
+    int count;
+} ParticlePool;
+
+void ClearParticles(void);                                   // Kill all live particles and restart the random sequence
+void EmitParticles(Vector2 origin, int count, Color color);  // Spawn a burst, dropped silently when the pool is full
+void UpdateParticles(float deltaTime);                       // Integrate and remove expired particles
+void DrawParticles(void);                                    // Draw all live particles in a single quad batch
+int GetParticleCount(void);
+unsigned int GetParticleRandomState(void);                   // Lets snapshots replay the same bursts
+void SetParticleRandomState(unsigned int state);
+
+#endif
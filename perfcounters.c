@@ -0,0 +1,94 @@
+#include "perfcounters.h"
+
+static const char *counterNames[HW_COUNTER_COUNT] = { "cycles", "instructions", "cache_misses", "branch_misses" };
+
+#if defined(__linux__)
+
+#include <linux/perf_event.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+static int counterFds[HW_COUNTER_COUNT] = { -1, -1, -1, -1 };
+
+static const unsigned long long counterConfigs[HW_COUNTER_COUNT] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+};
+
+static int OpenCounter(unsigned long long config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+bool InitHwCounters(void) {
+    bool any = false;
+    for (int i = 0; i < HW_COUNTER_COUNT; i++) {
+        if (counterFds[i] < 0) counterFds[i] = OpenCounter(counterConfigs[i]);
+        if (counterFds[i] >= 0) {
+            ioctl(counterFds[i], PERF_EVENT_IOC_RESET, 0);
+            ioctl(counterFds[i], PERF_EVENT_IOC_ENABLE, 0);
+            any = true;
+        }
+    }
+    return any;
+}
+
+void CloseHwCounters(void) {
+    for (int i = 0; i < HW_COUNTER_COUNT; i++) {
+        if (counterFds[i] >= 0) close(counterFds[i]);
+        counterFds[i] = -1;
+    }
+}
+
+bool IsHwCounterAvailable(HwCounter counter) {
+    return counterFds[counter] >= 0;
+}
+
+HwSample ReadHwCounters(void) {
+    HwSample sample = { 0 };
+    for (int i = 0; i < HW_COUNTER_COUNT; i++) {
+        unsigned long long data[3];     // value, time enabled, time running
+        if ((counterFds[i] < 0) || (read(counterFds[i], data, sizeof(data)) != sizeof(data))) continue;
+
+        // Scale up when the kernel had to multiplex more counters than the PMU has
+        if ((data[2] > 0) && (data[2] < data[1])) data[0] = (unsigned long long)((double)data[0] * data[1] / data[2]);
+        sample.values[i] = data[0];
+        sample.valid[i] = true;
+    }
+    return sample;
+}
+
+#else
+
+bool InitHwCounters(void) { return false; }
+void CloseHwCounters(void) { }
+bool IsHwCounterAvailable(HwCounter counter) { (void)counter; return false; }
+HwSample ReadHwCounters(void) { HwSample sample = { 0 }; return sample; }
+
+#endif
+
+HwSample SubtractHwSamples(HwSample end, HwSample start) {
+    HwSample delta = { 0 };
+    for (int i = 0; i < HW_COUNTER_COUNT; i++) {
+        delta.valid[i] = end.valid[i] && start.valid[i];
+        if (delta.valid[i]) delta.values[i] = end.values[i] - start.values[i];
+    }
+    return delta;
+}
+
+const char *GetHwCounterName(HwCounter counter) {
+    return counterNames[counter];
+}
@@ -0,0 +1,30 @@
+#ifndef PERFCOUNTERS_H
+#define PERFCOUNTERS_H
+
+#include <stdbool.h>
+
+// Hardware performance counters of the calling thread, user space only so they work with the
+// default perf_event_paranoid level. Linux only (perf_event_open); elsewhere, and in containers
+// that block the syscall, every counter simply reports as unavailable.
+
+typedef enum HwCounter {
+    HW_CYCLES,
+    HW_INSTRUCTIONS,
+    HW_CACHE_MISSES,
+    HW_BRANCH_MISSES,
+    HW_COUNTER_COUNT
+} HwCounter;
+
+typedef struct {
+    unsigned long long values[HW_COUNTER_COUNT];
+    bool valid[HW_COUNTER_COUNT];
+} HwSample;
+
+bool InitHwCounters(void);                  // Returns false when no counter could be opened
+void CloseHwCounters(void);
+bool IsHwCounterAvailable(HwCounter counter);
+HwSample ReadHwCounters(void);              // Running totals, subtract two reads to measure a region
+HwSample SubtractHwSamples(HwSample end, HwSample start);
+const char *GetHwCounterName(HwCounter counter);
+
+#endif
@@ -0,0 +1,135 @@
+#include "profiler.h"
+
+#if PROFILER_ENABLED
+
+#include "raylib.h"
+#include "stats.h"
+#include "timing.h"
+#include "trace.h"
+
+#include <math.h>
+
+static FrameProfiler profiler = { 0 };
+
+static const char *zoneNames[ZONE_COUNT] = { "input", "update", "draw", "swap", "collision" };
+static const Color zoneColors[ZONE_COUNT] = { SKYBLUE, ORANGE, LIME, GRAY, GOLD };
+
+static bool IsHwZone(ProfileZone zone) {
+    return profiler.hwEnabled && ((zone == ZONE_UPDATE) || (zone == ZONE_COLLISION));
+}
+
+bool EnableProfilerHwCounters(void) {
+    profiler.hwEnabled = InitHwCounters();
+    if (profiler.hwEnabled) {
+        TraceLog(LOG_INFO, "PROFILER: Hardware counters enabled (cycles %s, instructions %s, cache misses %s, branch misses %s)",
+                 IsHwCounterAvailable(HW_CYCLES) ? "yes" : "no", IsHwCounterAvailable(HW_INSTRUCTIONS) ? "yes" : "no",
+                 IsHwCounterAvailable(HW_CACHE_MISSES) ? "yes" : "no", IsHwCounterAvailable(HW_BRANCH_MISSES) ? "yes" : "no");
+    } else {
+        TraceLog(LOG_WARNING, "PROFILER: Hardware counters unavailable, continuing without them");
+    }
+    return profiler.hwEnabled;
+}
+
+void ProfileBegin(ProfileZone zone) {
+    if (IsHwZone(zone)) profiler.hwStart[zone] = ReadHwCounters();
+    profiler.start[zone] = GetMonotonicTime();
+}
+
+void ProfileEnd(ProfileZone zone) {
+    double end = GetMonotonicTime();
+    profiler.current[zone] += end - profiler.start[zone];
+    TraceComplete(zoneNames[zone], profiler.start[zone], end);
+
+    if (IsHwZone(zone)) {
+        HwSample delta = SubtractHwSamples(ReadHwCounters(), profiler.hwStart[zone]);
+        for (int i = 0; i < HW_COUNTER_COUNT; i++) {
+            profiler.hwCurrent[zone].values[i] += delta.values[i];
+            profiler.hwCurrent[zone].valid[i] = delta.valid[i];
+        }
+    }
+}
+
+void ProfileFrameEnd(void) {
+    double now = GetMonotonicTime();
+
+    for (int zone = 0; zone < ZONE_COUNT; zone++) {
+        profiler.history[zone][profiler.next] = (float)(profiler.current[zone] * 1000.0);
+        profiler.current[zone] = 0.0;
+
+        if (IsHwZone(zone)) {
+            for (int i = 0; i < HW_COUNTER_COUNT; i++) {
+                profiler.hwAverage[zone][i] += (profiler.hwCurrent[zone].values[i] - profiler.hwAverage[zone][i]) * 0.05;
+            }
+            HwSample empty = { 0 };
+            profiler.hwCurrent[zone] = empty;
+        }
+    }
+    profiler.frameHistory[profiler.next] = (profiler.lastFrameEnd > 0.0) ? (float)((now - profiler.lastFrameEnd) * 1000.0) : 0.0f;
+    profiler.lastFrameEnd = now;
+
+    profiler.next = (profiler.next + 1) % profilerHistorySize;
+    if (profiler.count < profilerHistorySize) profiler.count++;
+}
+
+float GetLastZoneTime(ProfileZone zone) {
+    if (profiler.count == 0) return 0.0f;
+    return profiler.history[zone][(profiler.next + profilerHistorySize - 1) % profilerHistorySize];
+}
+
+static SampleStats GetHistoryStats(const float *history) {
+    double samples[profilerHistorySize];
+    for (int i = 0; i < profiler.count; i++) samples[i] = history[i];
+    return ComputeSampleStats(samples, profiler.count);
+}
+
+static void DrawProfilerHwCounters(int x, int y) {
+    const ProfileZone zones[2] = { ZONE_UPDATE, ZONE_COLLISION };
+
+    DrawRectangle(x, y, profilerHistorySize + 10, 2 * 12 + 6, Fade(BLACK, 0.7f));
+    for (int i = 0; i < 2; i++) {
+        const double *average = profiler.hwAverage[zones[i]];
+        double ipc = (average[HW_CYCLES] > 0.0) ? average[HW_INSTRUCTIONS] / average[HW_CYCLES] : 0.0;
+        DrawText(TextFormat("%-9s IPC %.2f  cache miss %.0f  br miss %.0f /tick", zoneNames[zones[i]], ipc,
+                 average[HW_CACHE_MISSES], average[HW_BRANCH_MISSES]), x + 5, y + 3 + i * 12, 10, zoneColors[zones[i]]);
+    }
+}
+
+void DrawProfilerOverlay(int x, int y) {
+    const int width = profilerHistorySize + 10;
+    const int graphHeight = 50;
+    const float graphMaxMs = 33.3f;
+
+    DrawRectangle(x, y, width, 22 + (ZONE_COUNT + 1) * 12 + graphHeight, Fade(BLACK, 0.7f));
+    DrawText("zone      avg     p95     p99 ms", x + 5, y + 5, 10, WHITE);
+
+    for (int zone = 0; zone <= ZONE_COUNT; zone++) {
+        const float *history = (zone < ZONE_COUNT) ? profiler.history[zone] : profiler.frameHistory;
+        SampleStats stats = GetHistoryStats(history);
+        DrawText(TextFormat("%-7s %6.2f  %6.2f  %6.2f", (zone < ZONE_COUNT) ? zoneNames[zone] : "frame", stats.mean, stats.p95, stats.p99),
+                 x + 5, y + 19 + zone * 12, 10, (zone < ZONE_COUNT) ? zoneColors[zone] : WHITE);
+    }
+
+    // Frame time graph, oldest on the left, each bar stacked by zone
+    int baseY = y + 22 + (ZONE_COUNT + 1) * 12 + graphHeight - 4;
+
+    if (profiler.hwEnabled) DrawProfilerHwCounters(x, baseY + 4);
+    for (int i = 0; i < profiler.count; i++) {
+        int sample = (profiler.next - profiler.count + i + profilerHistorySize) % profilerHistorySize;
+        float stackMs = 0.0f;
+        for (int zone = 0; zone < profilerTopLevelZones; zone++) {
+            int bottom = baseY - (int)(stackMs / graphMaxMs * graphHeight);
+            stackMs += profiler.history[zone][sample];
+            int top = baseY - (int)(fminf(stackMs, graphMaxMs) / graphMaxMs * graphHeight);
+            if (bottom > top) DrawLine(x + 5 + i, bottom, x + 5 + i, top, zoneColors[zone]);
+        }
+    }
+
+    int budgetY = baseY - (int)(16.6f / graphMaxMs * graphHeight);
+    DrawLine(x + 5, budgetY, x + 5 + profilerHistorySize, budgetY, YELLOW);
+}
+
+const char *GetProfileZoneName(ProfileZone zone) {
+    return zoneNames[zone];
+}
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdbool.h>
+#include "perfcounters.h"
+
+// Zones are compiled in unless NDEBUG is set (Release builds); define ENABLE_PROFILER to keep them anyway
+// While a trace is being recorded every zone is also emitted as a trace event
+#if !defined(NDEBUG) || defined(ENABLE_PROFILER)
+    #define PROFILER_ENABLED 1
+#else
+    #define PROFILER_ENABLED 0
+#endif
+
+#define profilerHistorySize 240
+
+typedef enum ProfileZone {
+    ZONE_INPUT,
+    ZONE_UPDATE,
+    ZONE_DRAW,
+    ZONE_SWAP,      // EndDrawing: batch flush, buffer swap, frame limiter wait and input poll
+    ZONE_COLLISION, // Block collision scan, nested inside ZONE_UPDATE
+    ZONE_COUNT
+} ProfileZone;
+
+#define profilerTopLevelZones ZONE_COLLISION   // Zones before this one do not overlap and add up to the frame
+
+#if PROFILER_ENABLED
+    #define PROFILE_BEGIN(zone) ProfileBegin(zone)
+    #define PROFILE_END(zone) ProfileEnd(zone)
+    #define PROFILE_FRAME_END() ProfileFrameEnd()
+#else
+    #define PROFILE_BEGIN(zone) ((void)0)
+    #define PROFILE_END(zone) ((void)0)
+    #define PROFILE_FRAME_END() ((void)0)
+#endif
+
+#if PROFILER_ENABLED
+typedef struct {
+    double start[ZONE_COUNT];
+    double current[ZONE_COUNT];                     // Seconds accumulated by each zone in the running frame
+    float history[ZONE_COUNT][profilerHistorySize]; // Milliseconds per zone per frame
+    float frameHistory[profilerHistorySize];        // Milliseconds between frame ends
+    double lastFrameEnd;
+    int next;
+    int count;
+
+    // Optional hardware counters, read only around the simulation zones (update, collision)
+    bool hwEnabled;
+    HwSample hwStart[ZONE_COUNT];
+    HwSample hwCurrent[ZONE_COUNT];                 // Accumulated over the running frame
+    double hwAverage[ZONE_COUNT][HW_COUNTER_COUNT]; // Moving average per frame (one tick per GAME frame)
+} FrameProfiler;
+
+void ProfileBegin(ProfileZone zone);
+void ProfileEnd(ProfileZone zone);
+void ProfileFrameEnd(void);                 // Commit the running frame to the history
+bool EnableProfilerHwCounters(void);        // Returns false when the platform or container exposes no counters
+void DrawProfilerOverlay(int x, int y);     // Rolling averages, p95/p99 per zone and a frame time graph
+float GetLastZoneTime(ProfileZone zone);    // Milliseconds spent in the zone during the last committed frame
+const char *GetProfileZoneName(ProfileZone zone);
+#endif
+
+#endif
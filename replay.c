@@ -0,0 +1,240 @@
+#include "replay.h"
+#include "allocator.h"
+#include "particles.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#define fnvOffsetBasis 14695981039346656037ull
+#define fnvPrime 1099511628211ull
+
+static const EmbeddedLevel *embedded = NULL;
+static int embeddedCount = 0;
+
+static unsigned long long HashBytes(unsigned long long hash, const void *data, size_t size) {
+    const unsigned char *bytes = data;
+    for (size_t i = 0; i < size; i++) hash = (hash ^ bytes[i]) * fnvPrime;
+    return hash;
+}
+
+void SetReplayEmbeddedLevels(const EmbeddedLevel *levels, int count) {
+    embedded = levels;
+    embeddedCount = count;
+}
+
+void BeginReplayRecording(InputReplay *replay, unsigned int seed, const char *levelName) {
+    replay->rows = gameState.layout.rows;
+    replay->columns = gameState.layout.columns;
+
+    const Level *level = GetGameLevel();
+    LevelGenParams params;
+    replay->levelSource = REPLAY_LEVEL_BUILTIN;
+    replay->levelName[0] = '\0';
+    replay->levelHash = 0;
+    if (level != NULL) {
+        replay->levelSource = REPLAY_LEVEL_FILE;
+        snprintf(replay->levelName, sizeof(replay->levelName), "%s", (levelName != NULL) ? levelName : "");
+        replay->levelHash = HashBytes(fnvOffsetBasis, level->data, level->dataSize);
+    } else if (GetGameLevelGenerator(&params)) {
+        replay->levelSource = REPLAY_LEVEL_GENERATED;
+        replay->generatorSeed = params.seed;
+        replay->levelHash = GetLevelGenHash(&params);
+    }
+
+    replay->seed = seed;
+    replay->runCount = 0;
+    replay->tickCount = 0;
+    replay->finalHash = 0;
+}
+
+// Recording is opt-in tooling, so growing the run list is allowed inside the GAME no-allocation zone
+static void AppendRun(InputReplay *replay, ReplayRun run) {
+    if (replay->runCount == replay->runCapacity) {
+        replay->runCapacity = (replay->runCapacity > 0) ? replay->runCapacity * 2 : 4096;
+        NO_ALLOCATIONS_SUSPEND();
+        replay->runs = GAME_REALLOC(replay->runs, replay->runCapacity * sizeof(ReplayRun));
+        NO_ALLOCATIONS_RESUME();
+    }
+    replay->runs[replay->runCount++] = run;
+    replay->tickCount += run.count;
+}
+
+void RecordReplayTick(InputReplay *replay, float deltaTime, GameInput input) {
+    if (replay->runCount > 0) {
+        ReplayRun *last = &replay->runs[replay->runCount - 1];
+        if ((last->deltaTime == deltaTime) && (last->input.left == input.left) && (last->input.right == input.right)) {
+            last->count++;
+            replay->tickCount++;
+            return;
+        }
+    }
+    AppendRun(replay, (ReplayRun){ 1, deltaTime, input });
+}
+
+// Delta times are written as hex floats so the replay feeds back bit-identical values
+bool SaveReplay(InputReplay *replay, const char *path) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) return false;
+
+    replay->finalHash = HashGameState();
+
+    fprintf(file, "# Block Kuzushi input replay: <ticks> <delta time> <left><right>\n");
+    fprintf(file, "version %d\nlevel %dx%d\nseed %u\n", replayFormatVersion, replay->rows, replay->columns, replay->seed);
+    if (replay->levelSource == REPLAY_LEVEL_FILE) fprintf(file, "file %016llx %s\n", replay->levelHash, replay->levelName);
+    else if (replay->levelSource == REPLAY_LEVEL_GENERATED) fprintf(file, "generated %u %016llx\n", replay->generatorSeed, replay->levelHash);
+    for (int i = 0; i < replay->runCount; i++) {
+        const ReplayRun *run = &replay->runs[i];
+        fprintf(file, "%d %a %c%c\n", run->count, run->deltaTime, run->input.left ? 'L' : '-', run->input.right ? 'R' : '-');
+    }
+    fprintf(file, "end %ld %016llx\n", replay->tickCount, replay->finalHash);
+    fclose(file);
+
+    TraceLog(LOG_INFO, "REPLAY: Saved %ld ticks to %s", replay->tickCount, path);
+    return true;
+}
+
+// Loads the session's level the way --level does and checks it still has the recorded content
+static bool LoadReplayLevel(InputReplay *replay, const char *path) {
+    if (replay->levelSource == REPLAY_LEVEL_GENERATED) {
+        LevelGenParams params = GetDefaultLevelGenParams(replay->generatorSeed, replay->rows, replay->columns);
+        if (GetLevelGenHash(&params) == replay->levelHash) return true;
+        TraceLog(LOG_WARNING, "REPLAY: %s: the generator no longer produces the recorded level", path);
+        return false;
+    }
+    if (replay->levelSource != REPLAY_LEVEL_FILE) return true;
+
+    bool loaded = false;
+    for (int i = 0; (i < embeddedCount) && !loaded; i++) {
+        if (strcmp(embedded[i].name, replay->levelName) == 0) loaded = LoadLevelFromMemory(&replay->level, embedded[i].data, embedded[i].size);
+    }
+    if (!loaded && IsFileExtension(replay->levelName, ".txt")) {
+        size_t size = 0;
+        replay->levelText = PackLevelText(replay->levelName, &size);
+        loaded = (replay->levelText != NULL) && LoadLevelFromMemory(&replay->level, replay->levelText, size);
+    }
+    else if (!loaded) loaded = LoadLevelFile(&replay->level, replay->levelName);
+
+    if (!loaded) {
+        TraceLog(LOG_WARNING, "REPLAY: %s: cannot load level %s", path, replay->levelName);
+        return false;
+    }
+    if (HashBytes(fnvOffsetBasis, replay->level.data, replay->level.dataSize) != replay->levelHash) {
+        TraceLog(LOG_WARNING, "REPLAY: %s: level %s changed since the session was recorded", path, replay->levelName);
+        return false;
+    }
+    return true;
+}
+
+bool LoadReplay(InputReplay *replay, const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) {
+        TraceLog(LOG_WARNING, "REPLAY: Cannot open %s", path);
+        return false;
+    }
+
+    ReplayRun *runs = replay->runs;
+    int runCapacity = replay->runCapacity;
+    *replay = (InputReplay){ .runs = runs, .runCapacity = runCapacity };
+
+    char line[128];
+    bool valid = true;
+    long endTicks = -1;
+    while (valid && (fgets(line, sizeof(line), file) != NULL)) {
+        int version, count;
+        float deltaTime;
+        char left, right;
+
+        if ((line[0] == '#') || (line[0] == '\n')) continue;
+        else if (sscanf(line, "version %d", &version) == 1) valid = (version >= 1) && (version <= replayFormatVersion);
+        else if (sscanf(line, "level %dx%d", &replay->rows, &replay->columns) == 2) continue;
+        else if (sscanf(line, "file %llx %255[^\n]", &replay->levelHash, replay->levelName) == 2) replay->levelSource = REPLAY_LEVEL_FILE;
+        else if (sscanf(line, "generated %u %llx", &replay->generatorSeed, &replay->levelHash) == 2) replay->levelSource = REPLAY_LEVEL_GENERATED;
+        else if (sscanf(line, "seed %u", &replay->seed) == 1) continue;
+        else if (sscanf(line, "end %ld %llx", &endTicks, &replay->finalHash) == 2) break;
+        else if (sscanf(line, "%d %a %c%c", &count, &deltaTime, &left, &right) == 4) {
+            AppendRun(replay, (ReplayRun){ count, deltaTime, { left == 'L', right == 'R' } });
+        }
+        else valid = false;
+
+        if (!valid) TraceLog(LOG_WARNING, "REPLAY: %s: unsupported line \"%.*s\"", path, (int)strcspn(line, "\n"), line);
+    }
+    fclose(file);
+
+    if (valid && (endTicks >= 0) && (endTicks != replay->tickCount)) {
+        TraceLog(LOG_WARNING, "REPLAY: %s: expected %ld ticks, found %ld", path, endTicks, replay->tickCount);
+        valid = false;
+    }
+    return valid && LoadReplayLevel(replay, path);
+}
+
+void UnloadReplay(InputReplay *replay) {
+    if (GetGameLevel() == &replay->level) SetGameLevel(NULL);
+    UnloadLevelFile(&replay->level);
+    GAME_FREE(replay->levelText);
+    replay->levelText = NULL;
+    GAME_FREE(replay->runs);
+    replay->runs = NULL;
+    replay->runCount = 0;
+    replay->runCapacity = 0;
+    replay->tickCount = 0;
+}
+
+long RunReplay(const InputReplay *replay) {
+    if (replay->levelSource == REPLAY_LEVEL_FILE) SetGameLevel(&replay->level);
+    else if (replay->levelSource == REPLAY_LEVEL_GENERATED) {
+        LevelGenParams params = GetDefaultLevelGenParams(replay->generatorSeed, replay->rows, replay->columns);
+        SetGameLevelGenerator(&params);
+    } else {
+        SetGameLevel(NULL);
+        SetDefaultLevelSize(replay->rows, replay->columns);
+    }
+    InitGameState(replay->seed);
+    currentScreen = GAME;
+
+    for (int i = 0; i < replay->runCount; i++) {
+        const ReplayRun *run = &replay->runs[i];
+        for (int t = 0; t < run->count; t++) UpdateGame(run->deltaTime, run->input);
+    }
+    return replay->tickCount;
+}
+
+#define HASH_FIELD(hash, field) hash = HashBytes(hash, &(field), sizeof(field))
+
+// Blocks are hashed in their original rectangle, visible flag and int health form, so recorded hashes stay valid
+static unsigned long long HashBlock(unsigned long long hash, Rectangle rect, bool visible, int health) {
+    HASH_FIELD(hash, rect);
+    HASH_FIELD(hash, visible);
+    HASH_FIELD(hash, health);
+    return hash;
+}
+
+unsigned long long HashGameState(void) {
+    unsigned long long hash = fnvOffsetBasis;
+    const GameState *state = &gameState;
+
+    HASH_FIELD(hash, state->paddle);
+    HASH_FIELD(hash, state->lives);
+    HASH_FIELD(hash, state->mainBall.position);
+    HASH_FIELD(hash, state->mainBall.speedX);
+    HASH_FIELD(hash, state->mainBall.speedY);
+    HASH_FIELD(hash, state->mainBall.active);
+    for (int i = 0; i < state->layout.rows; i++) {
+        for (int j = 0; j < state->layout.columns; j++) hash = HashBlock(hash, GetBlockRect(i, j), GetBlock(i, j)->visible, GetBlock(i, j)->health);
+    }
+    hash = HashBlock(hash, state->flashingBlock.rect, state->flashingBlock.visible, 1);
+    HASH_FIELD(hash, state->flashingBlockVisible);
+    HASH_FIELD(hash, state->powerUp.position);
+    HASH_FIELD(hash, state->powerUp.active);
+    HASH_FIELD(hash, state->resetTimer);
+    HASH_FIELD(hash, state->isResetting);
+    HASH_FIELD(hash, state->ballStartDelay);
+    HASH_FIELD(hash, state->ballDelayed);
+    HASH_FIELD(hash, state->blocksRemaining);
+    HASH_FIELD(hash, state->elapsedTime);
+    HASH_FIELD(hash, state->randomState);
+    HASH_FIELD(hash, currentScreen);
+
+    int particles = GetParticleCount();
+    HASH_FIELD(hash, particles);
+    return hash;
+}
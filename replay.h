@@ -0,0 +1,52 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <stdbool.h>
+#include "embedded_levels.h"
+#include "game.h"
+
+#define replayFormatVersion 2       // 2 adds the level source, version 1 sessions are all on the built-in layout
+#define replayLevelNameLength 256
+
+// Where the session's level came from, so RunReplay can play the same one again
+typedef enum ReplayLevelSource {
+    REPLAY_LEVEL_BUILTIN,       // Built-in layout at rows x columns
+    REPLAY_LEVEL_FILE,          // --level: embedded level name, .lvl or .txt path
+    REPLAY_LEVEL_GENERATED      // --procedural: GetDefaultLevelGenParams(generatorSeed, rows, columns)
+} ReplayLevelSource;
+
+// Consecutive ticks with the same delta time and input, stored as one line of the replay file
+typedef struct {
+    int count;
+    float deltaTime;
+    GameInput input;
+} ReplayRun;
+
+// Input session for one level: its grid size and source, the seed passed to InitGameState, then
+// every UpdateGame tick after it
+typedef struct {
+    int rows, columns;
+    ReplayLevelSource levelSource;
+    char levelName[replayLevelNameLength];
+    unsigned long long levelHash;   // FNV-1a of the .lvl bytes, or GetLevelGenHash(), checked by LoadReplay
+    unsigned int generatorSeed;
+    Level level;                    // Loaded by LoadReplay for REPLAY_LEVEL_FILE
+    unsigned char *levelText;       // Packed .txt source backing level
+    unsigned int seed;
+    ReplayRun *runs;
+    int runCount;
+    int runCapacity;
+    long tickCount;
+    unsigned long long finalHash;   // HashGameState() after the last tick, 0 when the file has no end line
+} InputReplay;
+
+void BeginReplayRecording(InputReplay *replay, unsigned int seed, const char *levelName); // Clear the replay and start a session of the current level from this seed, levelName is what --level loaded it from
+void RecordReplayTick(InputReplay *replay, float deltaTime, GameInput input);
+bool SaveReplay(InputReplay *replay, const char *path);                 // Text file, the current game state hash is stored as the final hash
+bool LoadReplay(InputReplay *replay, const char *path);                 // Also loads the session's level and fails when its content changed
+void UnloadReplay(InputReplay *replay);
+long RunReplay(const InputReplay *replay);                              // Restart the session's level and feed every tick through UpdateGame
+void SetReplayEmbeddedLevels(const EmbeddedLevel *levels, int count);   // Levels LoadReplay looks up by name before trying a path
+unsigned long long HashGameState(void);                                 // FNV-1a over the simulation state, padding bytes excluded
+
+#endif
@@ -0,0 +1,124 @@
+#include "resolution.h"
+#include "counters.h"
+
+#include <math.h>
+
+#define missThreshold 1.2f      // Frame time over budget * this counts as a missed frame
+#define missFramesToDrop 3
+#define cooldownAfterChange 30
+#define baseRaiseDelay 120
+#define maxRaiseDelay 1920
+
+static DynamicResolution res = { 0 };
+
+void InitDynamicResolution(int width, int height, float budget, bool adaptive) {
+    res.target = LoadRenderTexture(width, height);
+    SetTextureFilter(res.target.texture, TEXTURE_FILTER_BILINEAR);
+    res.width = width;
+    res.height = height;
+    res.scale = resolutionMaxScale;
+    res.adaptive = adaptive;
+    res.budget = budget;
+    res.raiseDelayFrames = baseRaiseDelay;
+}
+
+void UnloadDynamicResolution(void) {
+    UnloadRenderTexture(res.target);
+}
+
+static void SetScale(float scale) {
+    if (scale < resolutionMinScale) scale = resolutionMinScale;
+    if (scale > resolutionMaxScale) scale = resolutionMaxScale;
+    res.scale = scale;
+    res.cooldownFrames = cooldownAfterChange;
+    res.missFrames = 0;
+    res.stableFrames = 0;
+}
+
+void UpdateResolutionScale(float frameTime, float busyTime) {
+    res.frameTimes[res.historyNext] = frameTime;
+    res.busyTimes[res.historyNext] = busyTime;
+    res.historyNext = (res.historyNext + 1) % resolutionHistorySize;
+    res.framesSinceRaise++;
+
+    if (!res.adaptive) return;
+    if (res.cooldownFrames > 0) {
+        res.cooldownFrames--;
+        return;
+    }
+
+    // GPU cost is not directly measurable through rlgl, it shows up as swap back-pressure in the
+    // total frame time, so drops key off frame time and raises additionally require CPU headroom
+    if (frameTime > res.budget * missThreshold) {
+        res.stableFrames = 0;
+        if (++res.missFrames >= missFramesToDrop) {
+            // A raise that misses right away means the previous scale was the sustainable one
+            if (res.framesSinceRaise < baseRaiseDelay && res.raiseDelayFrames < maxRaiseDelay) res.raiseDelayFrames *= 2;
+            SetScale(res.scale - resolutionStep);
+        }
+    } else {
+        res.missFrames = 0;
+        if (busyTime < res.budget * 0.5f && res.scale < resolutionMaxScale) {
+            if (++res.stableFrames >= res.raiseDelayFrames) {
+                SetScale(res.scale + resolutionStep);
+                res.framesSinceRaise = 0;
+            }
+        } else {
+            res.stableFrames = 0;
+        }
+    }
+}
+
+void BeginSceneRender(Camera2D camera) {
+    COUNT_BATCH();
+    BeginTextureMode(res.target);
+    ClearBackground(BLACK);
+    camera.offset = (Vector2){ camera.offset.x * res.scale, camera.offset.y * res.scale };
+    camera.zoom *= res.scale;
+    COUNT_BATCH();
+    BeginMode2D(camera);
+}
+
+void EndSceneRender(void) {
+    COUNT_BATCH();
+    EndMode2D();
+    COUNT_BATCH();
+    EndTextureMode();
+}
+
+void DrawSceneToScreen(void) {
+    float width = res.width * res.scale;
+    float height = res.height * res.scale;
+    // Render textures are stored bottom-up, so the scene region starts at the top rows and is read flipped
+    Rectangle source = { 0, res.height - height, width, -height };
+    DrawTexturePro(res.target.texture, source, (Rectangle){ 0, 0, GetScreenWidth(), GetScreenHeight() }, (Vector2){ 0, 0 }, 0.0f, WHITE);
+}
+
+void DrawResolutionOverlay(int x, int y) {
+    const int graphHeight = 60;
+    const float msToPixels = graphHeight / (res.budget * 2000.0f);   // Graph top is twice the budget
+
+    DrawRectangle(x, y, resolutionHistorySize * 2 + 10, graphHeight + 40, Fade(BLACK, 0.7f));
+    DrawText(TextFormat("Scale %.2f (%dx%d)%s", res.scale, (int)(res.width * res.scale), (int)(res.height * res.scale),
+             res.adaptive ? "" : " fixed"), x + 5, y + 5, 10, WHITE);
+
+    int baseY = y + 30 + graphHeight;
+    for (int i = 0; i < resolutionHistorySize; i++) {
+        int sample = (res.historyNext + i) % resolutionHistorySize;
+        float frameMs = res.frameTimes[sample] * 1000.0f;
+        float busyMs = res.busyTimes[sample] * 1000.0f;
+        int frameHeight = (int)fminf(frameMs * msToPixels, graphHeight);
+        int busyHeight = (int)fminf(busyMs * msToPixels, graphHeight);
+        Color color = (res.frameTimes[sample] > res.budget * missThreshold) ? RED : GREEN;
+        DrawRectangle(x + 5 + i * 2, baseY - frameHeight, 2, frameHeight, color);
+        DrawRectangle(x + 5 + i * 2, baseY - busyHeight, 2, busyHeight, SKYBLUE);
+    }
+
+    int budgetY = baseY - (int)(res.budget * 1000.0f * msToPixels);
+    DrawLine(x + 5, budgetY, x + 5 + resolutionHistorySize * 2, budgetY, YELLOW);
+    DrawText(TextFormat("%.1f ms", res.budget * 1000.0f), x + 5, y + 17, 10, YELLOW);
+}
+
+float GetResolutionScale(void) {
+    return res.scale;
+}
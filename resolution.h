@@ -0,0 +1,38 @@
+#ifndef RESOLUTION_H
+#define RESOLUTION_H
+
+#include "raylib.h"
+
+#define resolutionMinScale 0.5f
+#define resolutionMaxScale 1.0f
+#define resolutionStep 0.05f
+#define resolutionHistorySize 120
+
+// The scene is rendered into the top-left (scale * size) region of one full-size render texture
+// and stretched over the window, so a scale change never reallocates anything
+typedef struct {
+    RenderTexture2D target;
+    int width, height;
+    float scale;
+    bool adaptive;
+    float budget;               // Frame time to hold, in seconds
+    int missFrames;
+    int stableFrames;
+    int cooldownFrames;
+    int raiseDelayFrames;       // Stable frames required before scaling back up, grows when a raise immediately misses
+    int framesSinceRaise;
+    float frameTimes[resolutionHistorySize];
+    float busyTimes[resolutionHistorySize];
+    int historyNext;
+} DynamicResolution;
+
+void InitDynamicResolution(int width, int height, float budget, bool adaptive);
+void UnloadDynamicResolution(void);
+void UpdateResolutionScale(float frameTime, float busyTime);    // Feed last frame's total and CPU busy time
+void BeginSceneRender(Camera2D camera);                         // Start drawing the scene at the current internal resolution, camera in scene pixels
+void EndSceneRender(void);
+void DrawSceneToScreen(void);                                   // Upscale the scene to the window, call inside BeginDrawing()
+void DrawResolutionOverlay(int x, int y);                       // Scale and frame time history graph
+float GetResolutionScale(void);
+
+#endif
@@ -0,0 +1,22 @@
+#ifndef RLALLOC_H
+#define RLALLOC_H
+
+#include <stddef.h>
+
+// Force-included into raylib (and everything that links it) when ALLOCATOR_HOOKS is on, so that
+// raylib's RL_MALLOC/RL_CALLOC/RL_REALLOC/RL_FREE and the game share allocator.c.
+// Every block carries a small header, so memory from these must be released through them too.
+
+void *AllocatorMalloc(size_t size, const char *file, int line);
+void *AllocatorCalloc(size_t count, size_t size, const char *file, int line);
+void *AllocatorRealloc(void *ptr, size_t size, const char *file, int line);
+void AllocatorFree(void *ptr);
+
+#if defined(ALLOCATOR_HOOKS)
+    #define RL_MALLOC(sz) AllocatorMalloc(sz, __FILE__, __LINE__)
+    #define RL_CALLOC(n, sz) AllocatorCalloc(n, sz, __FILE__, __LINE__)
+    #define RL_REALLOC(ptr, sz) AllocatorRealloc(ptr, sz, __FILE__, __LINE__)
+    #define RL_FREE(ptr) AllocatorFree(ptr)
+#endif
+
+#endif
@@ -0,0 +1,100 @@
+#include "startup.h"
+#include "raylib.h"
+#include "timing.h"
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#if defined(__linux__)
+#include <time.h>
+#include <unistd.h>
+#endif
+
+typedef struct {
+    const char *name;
+    double end;                 // Seconds since process start
+} StartupPhase;
+
+static struct {
+    double origin;              // GetMonotonicTime() at BeginStartupTimeline
+    double execToMain;          // Loader, libraries and static constructors; 0 when unknown
+    StartupPhase phases[startupMaxPhases];
+    int count;
+    int reported;
+} timeline = { 0 };
+
+// Age of the process from the kernel's start time, with clock tick resolution (usually 10 ms)
+static double GetProcessAge(void) {
+#if defined(__linux__)
+    FILE *file = fopen("/proc/self/stat", "r");
+    if (file == NULL) return 0.0;
+
+    // The command name (field 2) may contain spaces, fields are counted from its closing parenthesis
+    char line[1024];
+    bool read = (fgets(line, sizeof(line), file) != NULL);
+    fclose(file);
+    char *fields = read ? strrchr(line, ')') : NULL;
+    unsigned long long startTicks = 0;
+    if ((fields == NULL) || (sscanf(fields + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u %*d %*d %*d %*d %*d %*d %llu", &startTicks) != 1)) return 0.0;
+
+    struct timespec now;
+    clock_gettime(CLOCK_BOOTTIME, &now);
+    double age = (double)now.tv_sec + (double)now.tv_nsec * 1e-9 - (double)startTicks / (double)sysconf(_SC_CLK_TCK);
+    return (age > 0.0) ? age : 0.0;
+#else
+    return 0.0;
+#endif
+}
+
+void BeginStartupTimeline(void) {
+    timeline.origin = GetMonotonicTime();
+    timeline.execToMain = GetProcessAge();
+    timeline.count = 0;
+    timeline.reported = 0;
+    if (timeline.execToMain > 0.0) StartupMark("exec to main");
+}
+
+double GetStartupTime(void) {
+    return timeline.execToMain + (GetMonotonicTime() - timeline.origin);
+}
+
+void StartupMark(const char *name) {
+    if (timeline.count == startupMaxPhases) return;
+    // The first phase ends at main, not at the time it is marked
+    double end = (timeline.count == 0) && (timeline.execToMain > 0.0) ? timeline.execToMain : GetStartupTime();
+    timeline.phases[timeline.count++] = (StartupPhase){ name, end };
+}
+
+// Current and peak resident set size in kB, from /proc/self/status
+static bool GetResidentMemory(long *current, long *peak) {
+#if defined(__linux__)
+    FILE *file = fopen("/proc/self/status", "r");
+    if (file == NULL) return false;
+
+    char line[256];
+    *current = *peak = -1;
+    while (fgets(line, sizeof(line), file) != NULL) {
+        sscanf(line, "VmRSS: %ld", current);
+        sscanf(line, "VmHWM: %ld", peak);
+    }
+    fclose(file);
+    return (*current >= 0) && (*peak >= 0);
+#else
+    (void)current;
+    (void)peak;
+    return false;
+#endif
+}
+
+void ReportStartupTimeline(void) {
+    for (int i = timeline.reported; i < timeline.count; i++) {
+        double start = (i > 0) ? timeline.phases[i - 1].end : 0.0;
+        TraceLog(LOG_INFO, "STARTUP: %-28s %8.1f ms, done at %8.1f ms", timeline.phases[i].name,
+                 (timeline.phases[i].end - start) * 1000.0, timeline.phases[i].end * 1000.0);
+    }
+    timeline.reported = timeline.count;
+
+    long current, peak;
+    if (GetResidentMemory(&current, &peak)) TraceLog(LOG_INFO, "STARTUP: Resident memory %.1f MB, peak %.1f MB", current / 1024.0, peak / 1024.0);
+}
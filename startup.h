@@ -0,0 +1,14 @@
+#ifndef STARTUP_H
+#define STARTUP_H
+
+// Startup timeline: named phases from process start to the first MENU frame, so cold boot time on
+// the kiosks can be broken down. Each mark ends the phase that began at the previous one.
+
+#define startupMaxPhases 16
+
+void BeginStartupTimeline(void);            // First thing in main, also measures exec to main where the OS tells
+void StartupMark(const char *name);         // Name must outlive the timeline (string literal)
+void ReportStartupTimeline(void);           // Log the phases marked since the last report and the resident memory
+double GetStartupTime(void);                // Seconds since the process started, or since BeginStartupTimeline
+
+#endif
@@ -0,0 +1,39 @@
+#include "stats.h"
+
+#include <stdlib.h>
+
+static int CompareDoubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+void SortSamples(double *samples, int count) {
+    qsort(samples, count, sizeof(double), CompareDoubles);
+}
+
+double SamplePercentile(const double *sorted, int count, double percent) {
+    if (count == 0) return 0.0;
+    int index = (int)(count * percent / 100.0);
+    if (index >= count) index = count - 1;
+    return sorted[index];
+}
+
+SampleStats ComputeSampleStats(double *samples, int count) {
+    SampleStats stats = { 0 };
+    if (count == 0) return stats;
+
+    SortSamples(samples, count);
+
+    double sum = 0.0;
+    for (int i = 0; i < count; i++) sum += samples[i];
+
+    stats.count = count;
+    stats.min = samples[0];
+    stats.mean = sum / count;
+    stats.median = SamplePercentile(samples, count, 50);
+    stats.p95 = SamplePercentile(samples, count, 95);
+    stats.p99 = SamplePercentile(samples, count, 99);
+    stats.max = samples[count - 1];
+    return stats;
+}
@@ -0,0 +1,19 @@
+#ifndef STATS_H
+#define STATS_H
+
+// Summary of a set of timing samples, all in the samples' own unit
+typedef struct {
+    int count;
+    double min;
+    double mean;
+    double median;
+    double p95;
+    double p99;
+    double max;
+} SampleStats;
+
+void SortSamples(double *samples, int count);
+double SamplePercentile(const double *sorted, int count, double percent);  // percent in [0, 100], samples must be sorted
+SampleStats ComputeSampleStats(double *samples, int count);               // Sorts samples in place
+
+#endif
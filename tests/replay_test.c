@@ -0,0 +1,338 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "../blackbox.h"
+#include "../embedded_levels.h"
+#include "../game.h"
+#include "../replay.h"
+#include "../stats.h"
+#include "../timing.h"
+
+// Replays recorded input sessions headlessly through UpdateGame and checks the final state hash.
+// With --baseline it also times the replays and fails when ticks/s falls below the stored
+// baseline by more than the tolerance. Throughput is compared relative to a calibration loop timed
+// in the same process, so the baseline follows the machine speed; it still depends on the build
+// type, CMake keeps one baseline per type. Sessions are recorded with `example --record-input <file>`
+// or generated from a scripted player with --generate.
+// --hitch replays a black box dump written by `example --hitch-ms <budget>` from its snapshot up
+// to the long frame, checks that it ends in the recorded state and times every tick.
+// Usage: replay_test [--baseline file [--tolerance 0.25] [--update-baseline]] [--repeat N] session...
+//        replay_test [--grid RxC] [--level name|--procedural seed] --generate <file> <seed> <ticks> [idle tick]
+//        replay_test --hitch <dump> [--repeat N]
+
+#define maxSessions 64
+#define baselineNameLength 128
+#define sampleSeconds 0.05
+#define calibrationBodies 256
+
+typedef struct {
+    char name[baselineNameLength];
+    double relative;                // Ticks per calibration step, what the test compares
+    double ticksPerSecond;          // This machine only, for comparing builds side by side
+} BaselineEntry;
+
+static BaselineEntry baseline[maxSessions];
+static int baselineCount = 0;
+
+static const char *GetBaseName(const char *path) {
+    const char *slash = strrchr(path, '/');
+    const char *backslash = strrchr(path, '\\');
+    if (backslash > slash) slash = backslash;
+    return (slash != NULL) ? slash + 1 : path;
+}
+
+static void LoadBaseline(const char *path) {
+    FILE *file = fopen(path, "r");
+    if (file == NULL) return;
+
+    char line[256];
+    while ((fgets(line, sizeof(line), file) != NULL) && (baselineCount < maxSessions)) {
+        BaselineEntry *entry = &baseline[baselineCount];
+        if (line[0] == '#') continue;
+        if (sscanf(line, "%127s %lf %lf", entry->name, &entry->relative, &entry->ticksPerSecond) >= 2) baselineCount++;
+    }
+    fclose(file);
+}
+
+static BaselineEntry *FindBaseline(const char *name) {
+    for (int i = 0; i < baselineCount; i++) {
+        if (!strcmp(baseline[i].name, name)) return &baseline[i];
+    }
+    return NULL;
+}
+
+static bool SaveBaseline(const char *path, int repeat) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) return false;
+
+    fprintf(file, "# replay_test baseline: <session> <ticks per calibration step> <ticks per second>, median of %d samples\n", repeat);
+    fprintf(file, "# Regenerate with a build of the same type: replay_test --baseline <this file> --update-baseline <sessions>\n");
+    for (int i = 0; i < baselineCount; i++) fprintf(file, "%s %.4f %.0f\n", baseline[i].name, baseline[i].relative, baseline[i].ticksPerSecond);
+    fclose(file);
+    return true;
+}
+
+// Stand-in for the simulation's kind of work (float integration, bounds checks and branches) that
+// never changes with the game code, so ticks per calibration step only moves when the game does
+static double RunCalibrationStep(void) {
+    static float position[calibrationBodies][2], velocity[calibrationBodies][2];
+    static bool initialized = false;
+    if (!initialized) {
+        for (int i = 0; i < calibrationBodies; i++) {
+            position[i][0] = (float)(i * 37 % 800);
+            position[i][1] = (float)(i * 53 % 450);
+            velocity[i][0] = (float)(i % 7) - 3.0f;
+            velocity[i][1] = (float)(i % 5) - 2.0f;
+        }
+        initialized = true;
+    }
+
+    double sum = 0.0;
+    for (int i = 0; i < calibrationBodies; i++) {
+        for (int axis = 0; axis < 2; axis++) {
+            float limit = (axis == 0) ? 800.0f : 450.0f;
+            position[i][axis] += velocity[i][axis] * (1.0f / 60.0f) * 60.0f;
+            if ((position[i][axis] < 0.0f) || (position[i][axis] > limit)) velocity[i][axis] = -velocity[i][axis];
+        }
+        sum += position[i][0] * 0.5 + position[i][1];
+    }
+    return sum;
+}
+
+// Calibration steps/s over one sample of at least sampleSeconds
+static double SampleCalibration(void) {
+    volatile double sink = 0.0;
+    long steps = 0;
+    double start = GetMonotonicTime();
+    double elapsed = 0.0;
+    while (elapsed < sampleSeconds) {
+        for (int i = 0; i < 64; i++) sink += RunCalibrationStep();
+        steps += 64;
+        elapsed = GetMonotonicTime() - start;
+    }
+    return steps / elapsed;
+}
+
+typedef struct {
+    double ticksPerSecond;
+    double relative;
+} Throughput;
+
+// Medians over several samples; each sample replays the session until it has run for at least
+// sampleSeconds so short sessions are not dominated by timer and scheduler noise. Every sample is
+// paired with a calibration sample right before it, so clock and load changes during the run
+// cancel out of the ratio. The first replay warms the caches and is not counted
+static Throughput MeasureThroughput(const InputReplay *replay, int repeat) {
+    double *ticksPerSecond = malloc(repeat * sizeof(double));
+    double *relative = malloc(repeat * sizeof(double));
+
+    RunReplay(replay);
+    for (int i = 0; i < repeat; i++) {
+        double stepsPerSecond = SampleCalibration();
+        long ticks = 0;
+        double start = GetMonotonicTime();
+        double elapsed = 0.0;
+        while (elapsed < sampleSeconds) {
+            ticks += RunReplay(replay);
+            elapsed = GetMonotonicTime() - start;
+        }
+        ticksPerSecond[i] = ticks / elapsed;
+        relative[i] = ticksPerSecond[i] / stepsPerSecond;
+    }
+
+    Throughput throughput = { ComputeSampleStats(ticksPerSecond, repeat).median, ComputeSampleStats(relative, repeat).median };
+    free(ticksPerSecond);
+    free(relative);
+    return throughput;
+}
+
+// Scripted player for sessions that were not recorded by hand: chases the ball with a drifting offset
+// and, when idleTick is positive, stops moving from that tick on so the session ends on a lost ball
+static int GenerateSession(const char *path, unsigned int seed, long ticks, long idleTick, const char *levelName) {
+    InputReplay replay = { 0 };
+    InitGameState(seed);
+    currentScreen = GAME;
+    BeginReplayRecording(&replay, seed, levelName); // After InitGameState, the session records the level size
+
+    for (long tick = 0; (tick < ticks) && (currentScreen == GAME); tick++) {
+        float offset = sinf(tick * 0.013f) * 40.0f;
+        float target = gameState.mainBall.position.x + offset;
+        float center = gameState.paddle.x + gameState.paddle.width / 2;
+        GameInput input = { target < center - 6, target > center + 6 };
+        if ((idleTick > 0) && (tick >= idleTick)) input = (GameInput){ 0 };
+
+        RecordReplayTick(&replay, 1.0f / 60.0f, input);
+        UpdateGame(1.0f / 60.0f, input);
+    }
+
+    bool saved = SaveReplay(&replay, path);
+    const char *outcome = (currentScreen == WIN) ? "win" : (currentScreen == GAME_OVER) ? "game over" : "tick limit";
+    printf("replay_test: generated %s, %ld ticks (%s), final hash %016llx\n", path, replay.tickCount, outcome, replay.finalHash);
+    UnloadReplay(&replay);
+    return saved ? 0 : 1;
+}
+
+#define hitchContextFrames 10
+
+// Times each replayed tick over several runs and keeps the slowest, to see whether the hitch is in the simulation
+static int ReplayHitchDump(const char *path, int repeat) {
+    BlackBoxDump dump = { 0 };
+    if (!LoadBlackBoxDump(&dump, path)) {
+        printf("FAIL %s cannot load\n", GetBaseName(path));
+        return 1;
+    }
+
+    double *tickTimes = malloc(dump.frameCount * sizeof(double));
+    double *slowest = calloc(dump.frameCount, sizeof(double));
+    unsigned long long hash = 0;
+    for (int run = 0; run < repeat; run++) {
+        if (!RunBlackBoxDump(&dump, tickTimes, &hash)) break;
+        for (int i = 0; i < dump.frameCount; i++) slowest[i] = fmax(slowest[i], tickTimes[i]);
+    }
+
+    printf("hitch at frame %lld: %.2f ms against a %.2f ms budget, replaying %d frames from frame %lld\n",
+           dump.hitchFrame, dump.hitchTime, dump.budget, dump.frameCount, dump.keyframe.frame);
+    printf("%8s %10s %10s %12s\n", "frame", "frame ms", "update ms", "replay ms");
+    for (int i = (dump.frameCount > hitchContextFrames) ? dump.frameCount - hitchContextFrames : 0; i < dump.frameCount; i++) {
+        const BlackBoxFrame *frame = &dump.frames[i];
+        printf("%8lld %10.2f %10.3f %12.4f\n", frame->frame, frame->frameTime, frame->zoneTimes[ZONE_UPDATE], slowest[i]);
+    }
+
+    bool matches = (hash == dump.finalHash);
+    printf("%s %s final state hash %016llx, recorded %016llx\n", matches ? "ok  " : "FAIL", GetBaseName(path), hash, dump.finalHash);
+
+    free(tickTimes);
+    free(slowest);
+    UnloadBlackBoxDump(&dump);
+    return matches ? 0 : 1;
+}
+
+// Same lookup as `example --level`: embedded level names first, then .lvl paths
+static bool SetSessionLevel(Level *level, const char *name) {
+    bool loaded = false;
+    for (int i = 0; (i < embeddedLevelCount) && !loaded; i++) {
+        if (!strcmp(embeddedLevels[i].name, name)) loaded = LoadLevelFromMemory(level, embeddedLevels[i].data, embeddedLevels[i].size);
+    }
+    if (!loaded) loaded = LoadLevelFile(level, name);
+    return loaded && SetGameLevel(level);
+}
+
+int main(int argc, char *argv[]) {
+    const char *baselinePath = NULL;
+    const char *sessions[maxSessions];
+    int sessionCount = 0;
+    double tolerance = 0.25;
+    bool updateBaseline = false;
+    int repeat = 9;
+    const char *hitchPath = NULL;
+    const char *levelName = NULL;
+    Level level = { 0 };
+
+    SetReplayEmbeddedLevels(embeddedLevels, embeddedLevelCount);
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--generate") && (i + 3 < argc)) {
+            long idleTick = (i + 4 < argc) ? atol(argv[i + 4]) : 0;
+            return GenerateSession(argv[i + 1], (unsigned int)strtoul(argv[i + 2], NULL, 10), atol(argv[i + 3]), idleTick, levelName);
+        }
+        else if (!strcmp(argv[i], "--level") && (i + 1 < argc)) {
+            levelName = argv[++i];
+            if (!SetSessionLevel(&level, levelName)) {
+                fprintf(stderr, "replay_test: cannot load level %s\n", levelName);
+                return 1;
+            }
+        }
+        else if (!strcmp(argv[i], "--procedural") && (i + 1 < argc)) {
+            int rows, columns;
+            GetDefaultLevelSize(&rows, &columns);
+            LevelGenParams params = GetDefaultLevelGenParams((unsigned int)strtoul(argv[++i], NULL, 10), rows, columns);
+            if (!SetGameLevelGenerator(&params)) return 1;
+        }
+        else if (!strcmp(argv[i], "--grid") && (i + 1 < argc)) {
+            int rows = 0, columns = 0;
+            if (sscanf(argv[++i], "%dx%d", &rows, &columns) == 2) SetDefaultLevelSize(rows, columns);
+        }
+        else if (!strcmp(argv[i], "--hitch") && (i + 1 < argc)) hitchPath = argv[++i];
+        else if (!strcmp(argv[i], "--baseline") && (i + 1 < argc)) baselinePath = argv[++i];
+        else if (!strcmp(argv[i], "--tolerance") && (i + 1 < argc)) tolerance = atof(argv[++i]);
+        else if (!strcmp(argv[i], "--repeat") && (i + 1 < argc)) repeat = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--update-baseline")) updateBaseline = true;
+        else if (sessionCount < maxSessions) sessions[sessionCount++] = argv[i];
+    }
+
+    if (repeat < 1) repeat = 1;
+    if (hitchPath != NULL) return ReplayHitchDump(hitchPath, repeat);
+
+    if (sessionCount == 0) {
+        fprintf(stderr, "replay_test: no sessions given\n");
+        return 1;
+    }
+    if (baselinePath != NULL) {
+        LoadBaseline(baselinePath);
+        if ((baselineCount == 0) && !updateBaseline) printf("replay_test: no baseline in %s, record one with --update-baseline\n", baselinePath);
+    }
+
+    int failures = 0;
+
+    for (int s = 0; s < sessionCount; s++) {
+        const char *name = GetBaseName(sessions[s]);
+        InputReplay replay = { 0 };
+
+        if (!LoadReplay(&replay, sessions[s])) {
+            printf("FAIL %-28s cannot load (format version, level missing or changed)\n", name);
+            failures++;
+            UnloadReplay(&replay);
+            continue;
+        }
+
+        RunReplay(&replay);
+        unsigned long long hash = HashGameState();
+        if (hash != replay.finalHash) {
+            printf("FAIL %-28s %ld ticks, state hash %016llx, expected %016llx\n", name, replay.tickCount, hash, replay.finalHash);
+            failures++;
+            UnloadReplay(&replay);
+            continue;
+        }
+
+        if (baselinePath == NULL) {
+            printf("ok   %-28s %ld ticks, state hash %016llx\n", name, replay.tickCount, hash);
+            UnloadReplay(&replay);
+            continue;
+        }
+
+        Throughput throughput = MeasureThroughput(&replay, repeat);
+        double ticksPerSecond = throughput.ticksPerSecond;
+        double relative = throughput.relative;
+        BaselineEntry *entry = FindBaseline(name);
+
+        if (updateBaseline) {
+            if ((entry == NULL) && (baselineCount < maxSessions)) {
+                entry = &baseline[baselineCount++];
+                snprintf(entry->name, sizeof(entry->name), "%s", name);
+            }
+            if (entry != NULL) {
+                entry->relative = relative;
+                entry->ticksPerSecond = ticksPerSecond;
+            }
+            printf("ok   %-28s %ld ticks, %.0f ticks/s, %.4f per step (baseline updated)\n", name, replay.tickCount, ticksPerSecond, relative);
+        } else if (entry == NULL) {
+            printf("ok   %-28s %ld ticks, %.0f ticks/s (no baseline)\n", name, replay.tickCount, ticksPerSecond);
+        } else {
+            double ratio = relative / entry->relative;
+            bool slow = ratio < 1.0 - tolerance;
+            printf("%s %-28s %ld ticks, %.0f ticks/s, %.4f per step, baseline %.4f (%+.1f%%)\n", slow ? "FAIL" : "ok  ", name,
+                   replay.tickCount, ticksPerSecond, relative, entry->relative, (ratio - 1.0) * 100.0);
+            if (slow) failures++;
+        }
+
+        UnloadReplay(&replay);
+    }
+
+    if (updateBaseline && (baselinePath != NULL) && !SaveBaseline(baselinePath, repeat)) {
+        fprintf(stderr, "replay_test: cannot write %s\n", baselinePath);
+        failures++;
+    }
+
+    printf("replay_test: %d of %d sessions passed\n", sessionCount - failures, sessionCount);
+    return (failures > 0) ? 1 : 0;
+}
@@ -0,0 +1,27 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+// Monotonic clock that works without a window, for headless tools and benchmarks
+// NOTE: Inside the game GetTime() is the same clock once the window is open
+
+#if defined(_WIN32)
+#include <windows.h>
+
+static inline double GetMonotonicTime(void) {
+    static LARGE_INTEGER frequency = { 0 };
+    LARGE_INTEGER counter;
+    if (frequency.QuadPart == 0) QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+}
+#else
+#include <time.h>
+
+static inline double GetMonotonicTime(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+#endif
+
+#endif
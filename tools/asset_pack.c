@@ -0,0 +1,126 @@
+#include <stdio.h>
+#include <string.h>
+#include "../allocator.h"
+#include "../assetpack.h"
+#include "external/sdefl.h"     // Implementation is compiled into raylib (SUPPORT_COMPRESSION_API)
+
+// Packs loose asset files into one .pak (see assetpack.h). Each blob is deflated when that saves
+// at least minCompressionSaving of it; already compressed formats (PNG, OGG...) are stored as they are.
+// Usage: asset_pack <output.pak> <file>...
+
+#define minCompressionSaving 0.1f
+
+typedef struct {
+    unsigned char *data;        // What goes into the file, compressed or not
+    int fileSize;
+    bool compressed;
+} PackedBlob;
+
+static unsigned int AlignBlob(unsigned int offset) {
+    return (offset + assetBlobAlignment - 1) & ~(unsigned int)(assetBlobAlignment - 1);
+}
+
+static bool PackFile(const char *path, AssetEntry *entry, PackedBlob *blob, struct sdefl *compressor) {
+    const char *name = GetFileName(path);
+    if (strlen(name) >= assetNameLength) {
+        fprintf(stderr, "asset_pack: %s: name is longer than %d characters\n", path, assetNameLength - 1);
+        return false;
+    }
+    if (GetAssetTypeFromName(name) == ASSET_UNSUPPORTED) {
+        fprintf(stderr, "asset_pack: %s: raylib is built without this file format\n", path);
+        return false;
+    }
+
+    int size = 0;
+    unsigned char *data = LoadFileData(path, &size);
+    if (data == NULL) {
+        fprintf(stderr, "asset_pack: cannot read %s\n", path);
+        return false;
+    }
+
+    unsigned char *packed = GAME_MALLOC(sdefl_bound(size));
+    int packedSize = sdeflate(compressor, packed, data, size, SDEFL_LVL_MAX);
+    blob->compressed = (packedSize < size * (1.0f - minCompressionSaving));
+    if (blob->compressed) {
+        blob->data = packed;
+        UnloadFileData(data);
+    } else {
+        blob->data = GAME_MALLOC(size);
+        memcpy(blob->data, data, size);
+        GAME_FREE(packed);
+        UnloadFileData(data);
+        packedSize = size;
+    }
+    blob->fileSize = packedSize;
+
+    strcpy(entry->name, name);
+    entry->type = GetAssetTypeFromName(name);
+    entry->compressed = blob->compressed;
+    entry->packedSize = (unsigned int)packedSize;
+    entry->size = (unsigned int)size;
+    printf("%-32s %10d -> %10d bytes%s\n", name, size, packedSize, blob->compressed ? " (deflate)" : "");
+    return true;
+}
+
+static bool WritePack(const char *outputPath, int fileCount, char *files[]) {
+    AssetEntry *entries = GAME_CALLOC(fileCount, sizeof(AssetEntry));
+    PackedBlob *blobs = GAME_CALLOC(fileCount, sizeof(PackedBlob));
+    struct sdefl *compressor = GAME_CALLOC(1, sizeof(struct sdefl));   // Close to 1 MB, too big for the stack
+
+    bool valid = true;
+    for (int i = 0; (i < fileCount) && valid; i++) {
+        valid = PackFile(files[i], &entries[i], &blobs[i], compressor);
+        for (int j = 0; (j < i) && valid; j++) {
+            if (strcmp(entries[i].name, entries[j].name) == 0) {
+                fprintf(stderr, "asset_pack: %s is packed twice, assets are looked up by file name\n", entries[i].name);
+                valid = false;
+            }
+        }
+    }
+
+    AssetPackHeader header = {
+        .magic = assetPackMagic,
+        .version = assetPackVersion,
+        .assetCount = (unsigned int)fileCount,
+        .indexOffset = sizeof(AssetPackHeader)
+    };
+    unsigned int offset = AlignBlob(header.indexOffset + fileCount * sizeof(AssetEntry));
+    for (int i = 0; i < fileCount; i++) {
+        entries[i].offset = offset;
+        offset = AlignBlob(offset + entries[i].packedSize);
+    }
+
+    FILE *file = valid ? fopen(outputPath, "wb") : NULL;
+    if (valid && (file == NULL)) {
+        fprintf(stderr, "asset_pack: cannot write %s\n", outputPath);
+        valid = false;
+    }
+    if (file != NULL) {
+        static const unsigned char padding[assetBlobAlignment] = { 0 };
+        valid = (fwrite(&header, sizeof(header), 1, file) == 1) && (fwrite(entries, sizeof(AssetEntry), fileCount, file) == (size_t)fileCount);
+        unsigned int position = header.indexOffset + fileCount * sizeof(AssetEntry);
+        for (int i = 0; (i < fileCount) && valid; i++) {
+            valid = (fwrite(padding, 1, entries[i].offset - position, file) == entries[i].offset - position) &&
+                    (fwrite(blobs[i].data, 1, blobs[i].fileSize, file) == (size_t)blobs[i].fileSize);
+            position = entries[i].offset + blobs[i].fileSize;
+        }
+        valid = (fclose(file) == 0) && valid;
+        if (!valid) remove(outputPath);     // A half written file would look up to date to the build
+        else printf("%s: %d assets, %u bytes\n", outputPath, fileCount, position);
+    }
+
+    for (int i = 0; i < fileCount; i++) GAME_FREE(blobs[i].data);
+    GAME_FREE(compressor);
+    GAME_FREE(blobs);
+    GAME_FREE(entries);
+    return valid;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "usage: asset_pack <output.pak> <file>...\n");
+        return 1;
+    }
+    SetTraceLogLevel(LOG_WARNING);
+    return WritePack(argv[1], argc - 2, argv + 2) ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+#include <stdio.h>
+#include <string.h>
+#include "../allocator.h"
+#include "../level.h"
+
+// Compiles a text level into the binary .lvl format loaded by `example --level <file>`,
+// prints the header of an existing .lvl with --info, or with --embed writes a C source file
+// that compiles the given levels into the executable (see embedded_levels.h)
+// Usage: level_convert <source.txt> <output.lvl>
+//        level_convert --info <level.lvl>
+//        level_convert --embed <output.c> <source.txt>...
+
+#define embedBytesPerLine 16
+
+// Entry name: the file name without directory and extension
+static void GetLevelName(const char *path, char *name, size_t size) {
+    const char *start = path;
+    for (const char *c = path; *c != '\0'; c++) if ((*c == '/') || (*c == '\\')) start = c + 1;
+    size_t length = strcspn(start, ".");
+    if (length >= size) length = size - 1;
+    memcpy(name, start, length);
+    name[length] = '\0';
+}
+
+static bool WriteEmbeddedLevels(const char *outputPath, int sourceCount, char *sources[]) {
+    FILE *file = fopen(outputPath, "w");
+    if (file == NULL) {
+        fprintf(stderr, "level_convert: cannot write %s\n", outputPath);
+        return false;
+    }
+
+    fprintf(file, "// Generated by level_convert --embed from %d level sources, do not edit\n", sourceCount);
+    fprintf(file, "#include \"embedded_levels.h\"\n");
+
+    bool valid = true;
+    for (int i = 0; (i < sourceCount) && valid; i++) {
+        size_t size = 0;
+        unsigned char *data = PackLevelText(sources[i], &size);
+        valid = (data != NULL);
+        if (!valid) break;
+
+        fprintf(file, "\n_Alignas(16) static const unsigned char level%d[%zu] = {", i, size);
+        for (size_t b = 0; b < size; b++) fprintf(file, "%s0x%02x,", (b % embedBytesPerLine == 0) ? "\n    " : " ", data[b]);
+        fprintf(file, "\n};\n");
+        GAME_FREE(data);
+    }
+
+    if (valid) {
+        fprintf(file, "\nconst EmbeddedLevel embeddedLevels[] = {\n");
+        for (int i = 0; i < sourceCount; i++) {
+            char name[64];
+            GetLevelName(sources[i], name, sizeof(name));
+            fprintf(file, "    { \"%s\", level%d, sizeof(level%d) },\n", name, i, i);
+        }
+        if (sourceCount == 0) fprintf(file, "    { 0 }\n");
+        fprintf(file, "};\n\nconst int embeddedLevelCount = %d;\n", sourceCount);
+    }
+
+    valid = (fclose(file) == 0) && valid;
+    if (!valid) remove(outputPath);     // A half written file would look up to date to the build
+    return valid;
+}
+
+int main(int argc, char *argv[]) {
+    if ((argc == 3) && !strcmp(argv[1], "--info")) {
+        Level level;
+        if (!LoadLevelFile(&level, argv[2])) return 1;
+        printf("%s: version %u, %dx%d cells of %.0fx%.0f, %zu bytes\n", argv[2], level.header->version,
+               level.header->rows, level.header->columns, level.header->cellWidth, level.header->cellHeight, level.dataSize);
+        UnloadLevelFile(&level);
+        return 0;
+    }
+
+    if ((argc >= 3) && !strcmp(argv[1], "--embed")) return WriteEmbeddedLevels(argv[2], argc - 3, argv + 3) ? 0 : 1;
+
+    if (argc != 3) {
+        printf("Usage: level_convert <source.txt> <output.lvl>\n       level_convert --info <level.lvl>\n"
+               "       level_convert --embed <output.c> <source.txt>...\n");
+        return 2;
+    }
+
+    return ConvertLevelText(argv[1], argv[2]) ? 0 : 1;
+}
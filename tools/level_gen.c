@@ -0,0 +1,123 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "../allocator.h"
+#include "../level.h"
+#include "../levelgen.h"
+#include "../timing.h"
+
+// Batch procedural level generation: levels for seeds first..first+count-1 are generated on
+// worker threads and written to <dir>/<content hash>.lvl. A file that already exists came from
+// identical parameters and is reused, so rerunning a batch only generates what is new.
+// <dir>/index.txt maps every seed of the batch to its file. <dir> is created when missing, its parent must exist.
+// Usage: level_gen <dir> [--count N] [--seed first] [--size RxC] [--threads N]
+
+#define maxThreads 64
+
+typedef struct {
+    const char *directory;
+    unsigned int firstSeed;
+    int count;
+    int rows, columns;
+    int next;                   // Next batch index to claim, shared by the workers
+    int generated;
+    int cached;
+    int failed;
+    unsigned long long *hashes; // Per batch index, for the index file
+} Batch;
+
+static void *GenerateWorker(void *argument) {
+    Batch *batch = argument;
+    size_t cells = (size_t)batch->rows * batch->columns;
+    unsigned char *health = GAME_MALLOC(cells);
+    unsigned char *types = GAME_MALLOC(cells);
+    char path[1024], temporary[1100];
+
+    for (;;) {
+        int index = __atomic_fetch_add(&batch->next, 1, __ATOMIC_RELAXED);
+        if (index >= batch->count) break;
+
+        LevelGenParams params = GetDefaultLevelGenParams(batch->firstSeed + index, batch->rows, batch->columns);
+        unsigned long long hash = GetLevelGenHash(&params);
+        batch->hashes[index] = hash;
+        snprintf(path, sizeof(path), "%s/%016llx.lvl", batch->directory, hash);
+
+        if (access(path, F_OK) == 0) {
+            __atomic_fetch_add(&batch->cached, 1, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        // Written under a private name and renamed, so readers and concurrent batches never see a partial file
+        GenerateLevelRows(&params, 0, params.rows - 1, health, types);
+        snprintf(temporary, sizeof(temporary), "%s.%d.tmp", path, index);
+        if (SaveLevelFile(temporary, params.rows, params.columns, 0, 0, health, types) && (rename(temporary, path) == 0)) {
+            __atomic_fetch_add(&batch->generated, 1, __ATOMIC_RELAXED);
+        } else {
+            remove(temporary);
+            __atomic_fetch_add(&batch->failed, 1, __ATOMIC_RELAXED);
+        }
+    }
+
+    GAME_FREE(health);
+    GAME_FREE(types);
+    return NULL;
+}
+
+static bool WriteIndex(const Batch *batch) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s/index.txt", batch->directory);
+    FILE *file = fopen(path, "w");
+    if (file == NULL) return false;
+
+    fprintf(file, "# seed file (level_gen version %d, %dx%d)\n", levelGenVersion, batch->rows, batch->columns);
+    for (int i = 0; i < batch->count; i++) fprintf(file, "%u %016llx.lvl\n", batch->firstSeed + i, batch->hashes[i]);
+    return fclose(file) == 0;
+}
+
+int main(int argc, char *argv[]) {
+    if ((argc < 2) || (argv[1][0] == '-')) {
+        printf("Usage: level_gen <dir> [--count N] [--seed first] [--size RxC] [--threads N]\n");
+        return 2;
+    }
+
+    Batch batch = { .directory = argv[1], .count = 1000, .rows = 5, .columns = 10 };
+    long threadCount = sysconf(_SC_NPROCESSORS_ONLN);
+    for (int i = 2; i < argc; i++) {
+        if (!strcmp(argv[i], "--count") && (i + 1 < argc)) batch.count = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--seed") && (i + 1 < argc)) batch.firstSeed = (unsigned int)strtoul(argv[++i], NULL, 10);
+        else if (!strcmp(argv[i], "--size") && (i + 1 < argc)) sscanf(argv[++i], "%dx%d", &batch.rows, &batch.columns);
+        else if (!strcmp(argv[i], "--threads") && (i + 1 < argc)) threadCount = atol(argv[++i]);
+    }
+    if (threadCount < 1) threadCount = 1;
+    if (threadCount > maxThreads) threadCount = maxThreads;
+    if ((batch.count < 1) || (batch.rows < 1) || (batch.rows > levelMaxDimension) || (batch.columns < 1) || (batch.columns > levelMaxDimension)) {
+        fprintf(stderr, "level_gen: invalid count or size\n");
+        return 2;
+    }
+
+    if ((mkdir(batch.directory, 0777) != 0) && (errno != EEXIST)) {
+        fprintf(stderr, "level_gen: cannot create %s\n", batch.directory);
+        return 1;
+    }
+
+    batch.hashes = GAME_CALLOC(batch.count, sizeof(unsigned long long));
+
+    double start = GetMonotonicTime();
+    pthread_t threads[maxThreads];
+    for (int i = 0; i < threadCount; i++) pthread_create(&threads[i], NULL, GenerateWorker, &batch);
+    for (int i = 0; i < threadCount; i++) pthread_join(threads[i], NULL);
+    double elapsed = GetMonotonicTime() - start;
+
+    bool indexed = WriteIndex(&batch);
+    printf("level_gen: %d levels of %dx%d in %.2f s on %ld threads (%d generated, %d cached, %d failed), %.0f levels/s\n",
+           batch.count, batch.rows, batch.columns, elapsed, threadCount, batch.generated, batch.cached, batch.failed,
+           batch.count / elapsed);
+    if (!indexed) fprintf(stderr, "level_gen: cannot write %s/index.txt\n", batch.directory);
+
+    GAME_FREE(batch.hashes);
+    return ((batch.failed == 0) && indexed) ? 0 : 1;
+}
@@ -0,0 +1,166 @@
+#include "trace.h"
+#include "profiler.h"
+#include "raylib.h"
+#include "timing.h"
+
+#include <pthread.h>
+#include <stdio.h>
+#include <string.h>
+
+static TraceBuffer buffers[traceMaxThreads] = { 0 };
+static int bufferCount = 0;
+static int threadCount = 0;                 // Ever registered, tids stay unique when rings are reused
+static bool bufferWarned = false;
+static pthread_mutex_t registerLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t keyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t bufferKey;             // Its destructor hands the ring back when the thread exits
+static _Thread_local TraceBuffer *threadBuffer = NULL;
+
+static bool tracing = false;             // Read by every thread, __atomic accesses only
+static unsigned int traceGeneration = 0;    // Bumped by StartTrace, each thread catches up on its next event
+static double traceStartTime = 0.0;
+
+static void ReleaseThreadBuffer(void *buffer) {
+    pthread_mutex_lock(&registerLock);
+    ((TraceBuffer *)buffer)->inUse = false;
+    pthread_mutex_unlock(&registerLock);
+}
+
+static void CreateBufferKey(void) {
+    pthread_key_create(&bufferKey, ReleaseThreadBuffer);
+}
+
+// A fresh ring first, then one whose events are from an older session, then any released one
+static TraceBuffer *TakeFreeBuffer(void) {
+    if (bufferCount < traceMaxThreads) return &buffers[bufferCount++];
+
+    unsigned int generation = __atomic_load_n(&traceGeneration, __ATOMIC_ACQUIRE);
+    TraceBuffer *released = NULL;
+    for (int i = 0; i < bufferCount; i++) {
+        if (buffers[i].inUse) continue;
+        if (buffers[i].generation != generation) return &buffers[i];
+        if (released == NULL) released = &buffers[i];
+    }
+    return released;
+}
+
+// Only a thread's first event takes the lock, every later one is a plain store into its own ring
+static TraceBuffer *GetThreadBuffer(void) {
+    if (threadBuffer != NULL) return threadBuffer;
+
+    pthread_once(&keyOnce, CreateBufferKey);
+    pthread_mutex_lock(&registerLock);
+    TraceBuffer *buffer = TakeFreeBuffer();
+    if (buffer != NULL) {
+        // Events left by the previous owner are not flushed under the new thread's name
+        __atomic_store_n(&buffer->generation, 0, __ATOMIC_RELEASE);
+        buffer->inUse = true;
+        buffer->tid = ++threadCount;
+        snprintf(buffer->name, sizeof(buffer->name), "thread %d", buffer->tid);
+    } else if (!bufferWarned) {
+        TraceLog(LOG_WARNING, "TRACE: More than %d threads alive, events of the extra ones are dropped", traceMaxThreads);
+        bufferWarned = true;
+    }
+    pthread_mutex_unlock(&registerLock);
+
+    if (buffer != NULL) pthread_setspecific(bufferKey, buffer);
+    threadBuffer = buffer;
+    return threadBuffer;
+}
+
+// Called on the main thread, which also flushes; other threads only see the new generation
+void StartTrace(void) {
+#if !PROFILER_ENABLED
+    TraceLog(LOG_WARNING, "TRACE: Profiler zones are compiled out (NDEBUG), only encoder, level reload and asset events are recorded; build with ENABLE_PROFILER for frame zones");
+#endif
+    traceStartTime = GetMonotonicTime();
+    __atomic_add_fetch(&traceGeneration, 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&tracing, true, __ATOMIC_RELEASE);
+}
+
+void StopTrace(void) {
+    __atomic_store_n(&tracing, false, __ATOMIC_RELEASE);
+}
+
+bool IsTracing(void) {
+    return __atomic_load_n(&tracing, __ATOMIC_ACQUIRE);
+}
+
+// Names are read by FlushTrace, so they are written under the lock
+void TraceSetThreadName(const char *name) {
+    TraceBuffer *buffer = GetThreadBuffer();
+    if (buffer == NULL) return;
+
+    pthread_mutex_lock(&registerLock);
+    snprintf(buffer->name, sizeof(buffer->name), "%s", name);
+    pthread_mutex_unlock(&registerLock);
+}
+
+void TraceComplete(const char *name, double start, double end) {
+    if (!__atomic_load_n(&tracing, __ATOMIC_ACQUIRE)) return;
+
+    TraceBuffer *buffer = GetThreadBuffer();
+    if (buffer == NULL) return;
+
+    // First event since StartTrace: the session starts here instead of the ring being reset under us
+    unsigned long long written = buffer->written;
+    unsigned int generation = __atomic_load_n(&traceGeneration, __ATOMIC_ACQUIRE);
+    if (buffer->generation != generation) {
+        __atomic_store_n(&buffer->first, written, __ATOMIC_RELAXED);
+        __atomic_store_n(&buffer->generation, generation, __ATOMIC_RELEASE);
+    }
+
+    TraceEvent *event = &buffer->events[written % traceEventCapacity];
+    event->name = name;
+    event->start = start;
+    event->duration = end - start;
+    __atomic_store_n(&buffer->written, written + 1, __ATOMIC_RELEASE);
+}
+
+bool FlushTrace(const char *path) {
+    FILE *file = fopen(path, "w");
+    if (file == NULL) return false;
+
+    fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"Block Kuzushi\"}}");
+
+    char names[traceMaxThreads][32];
+    int tids[traceMaxThreads];
+    pthread_mutex_lock(&registerLock);
+    int threads = bufferCount;
+    for (int i = 0; i < threads; i++) {
+        memcpy(names[i], buffers[i].name, sizeof(names[i]));
+        tids[i] = buffers[i].tid;
+    }
+    pthread_mutex_unlock(&registerLock);
+
+    unsigned int generation = __atomic_load_n(&traceGeneration, __ATOMIC_ACQUIRE);
+    long total = 0;
+    for (int i = 0; i < threads; i++) {
+        TraceBuffer *buffer = &buffers[i];
+        fprintf(file, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":\"%s\"}}", tids[i], names[i]);
+
+        // Nothing recorded by this thread since StartTrace
+        if (__atomic_load_n(&buffer->generation, __ATOMIC_ACQUIRE) != generation) continue;
+
+        // Threads keep writing while we read: skip a margin of the oldest slots once the ring has wrapped,
+        // those are the ones that may be overwritten under us
+        unsigned long long first = __atomic_load_n(&buffer->first, __ATOMIC_RELAXED);
+        unsigned long long written = __atomic_load_n(&buffer->written, __ATOMIC_ACQUIRE);
+        if (written - first > traceEventCapacity - 256) first = written - traceEventCapacity + 256;
+
+        for (unsigned long long e = first; e < written; e++) {
+            const TraceEvent *event = &buffer->events[e % traceEventCapacity];
+            if (event->start < traceStartTime) continue;
+            fprintf(file, ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                    event->name, tids[i], (event->start - traceStartTime) * 1e6, event->duration * 1e6);
+            total++;
+        }
+    }
+
+    fprintf(file, "\n]}\n");
+    fclose(file);
+
+    TraceLog(LOG_INFO, "TRACE: [%s] %ld events from %d threads written", path, total, threads);
+    return true;
+}
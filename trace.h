@@ -0,0 +1,36 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdbool.h>
+
+#define traceEventCapacity 32768   // Per thread, about 45 s of game frames before the oldest events are overwritten
+#define traceMaxThreads 6       // Threads alive at once: main, capture encoder, level watch and the asset decoders
+
+// Complete ("X") event, nesting is implied by time containment when the trace is viewed
+typedef struct {
+    const char *name;   // Must be a string literal or otherwise outlive the trace
+    double start;
+    double duration;
+} TraceEvent;
+
+// Preallocated ring owned by a single thread, the only one storing events into it. The flushing
+// thread reads `generation`, `first` and `written` atomically, tid and name under the register lock.
+// A ring goes back to the pool when its thread exits; it is flushed until another thread takes it
+typedef struct {
+    int tid;
+    char name[32];
+    bool inUse;
+    unsigned int generation;        // Trace session the events from `first` on belong to
+    unsigned long long first;       // `written` when the thread stored its first event of that session
+    unsigned long long written;
+    TraceEvent events[traceEventCapacity];
+} TraceBuffer;
+
+void StartTrace(void);                                          // Start a new session; Release builds record no profiler zones (ENABLE_PROFILER)
+void StopTrace(void);
+bool IsTracing(void);
+void TraceSetThreadName(const char *name);                      // Name shown for the calling thread in the viewer
+void TraceComplete(const char *name, double start, double end); // Times from GetMonotonicTime()
+bool FlushTrace(const char *path);                              // Write the rings as Chrome/Perfetto trace event JSON
+
+#endif